@@ -1456,22 +1456,44 @@ mt76_check_sta(struct mt76_dev *dev, struct sk_buff *skb)
 	ieee80211_sta_ps_transition(sta, ps);
 }
 
-void mt76_rx_complete(struct mt76_dev *dev, struct sk_buff_head *frames,
-		      struct napi_struct *napi)
+/* collect consecutive frames for the same hw and station, mac80211 takes
+ * each such run at once
+ */
+static void
+mt76_rx_list_add(struct mt76_dev *dev, struct sk_buff *skb,
+		 struct sk_buff_head *run, struct ieee80211_hw **run_hw,
+		 struct ieee80211_sta **run_sta, struct list_head *list)
 {
 	struct ieee80211_sta *sta;
 	struct ieee80211_hw *hw;
+
+	mt76_rx_convert(dev, skb, &hw, &sta);
+	if (!skb_queue_empty(run) && (hw != *run_hw || sta != *run_sta))
+		ieee80211_rx_list_batch(*run_hw, *run_sta, run, list);
+
+	*run_hw = hw;
+	*run_sta = sta;
+	__skb_queue_tail(run, skb);
+}
+
+void mt76_rx_complete(struct mt76_dev *dev, struct sk_buff_head *frames,
+		      struct napi_struct *napi)
+{
+	struct ieee80211_sta *sta = NULL;
+	struct ieee80211_hw *hw = NULL;
 	struct sk_buff *skb, *tmp;
+	struct sk_buff_head run;
 	LIST_HEAD(list);
 
+	__skb_queue_head_init(&run);
+
 	spin_lock(&dev->rx_lock);
 	while ((skb = __skb_dequeue(frames)) != NULL) {
 		struct sk_buff *nskb = skb_shinfo(skb)->frag_list;
 
 		mt76_check_ccmp_pn(skb);
 		skb_shinfo(skb)->frag_list = NULL;
-		mt76_rx_convert(dev, skb, &hw, &sta);
-		ieee80211_rx_list(hw, sta, skb, &list);
+		mt76_rx_list_add(dev, skb, &run, &hw, &sta, &list);
 
 		/* subsequent amsdu frames */
 		while (nskb) {
@@ -1479,10 +1501,11 @@ void mt76_rx_complete(struct mt76_dev *dev, struct sk_buff_head *frames,
 			nskb = nskb->next;
 			skb->next = NULL;
 
-			mt76_rx_convert(dev, skb, &hw, &sta);
-			ieee80211_rx_list(hw, sta, skb, &list);
+			mt76_rx_list_add(dev, skb, &run, &hw, &sta, &list);
 		}
 	}
+	if (!skb_queue_empty(&run))
+		ieee80211_rx_list_batch(hw, sta, &run, &list);
 	spin_unlock(&dev->rx_lock);
 
 	if (!napi) {
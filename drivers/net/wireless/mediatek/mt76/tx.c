@@ -385,6 +385,24 @@ mt76_txq_dequeue(struct mt76_phy *phy, struct mt76_txq *mtxq)
 	return skb;
 }
 
+static int
+mt76_txq_dequeue_bulk(struct mt76_phy *phy, struct mt76_txq *mtxq,
+		      struct sk_buff_head *skbs, int budget)
+{
+	struct ieee80211_txq *txq = mtxq_to_txq(mtxq);
+	struct ieee80211_tx_info *info;
+	struct sk_buff *skb;
+	int n;
+
+	n = ieee80211_tx_dequeue_bulk(phy->hw, txq, skbs, budget);
+	skb_queue_walk(skbs, skb) {
+		info = IEEE80211_SKB_CB(skb);
+		info->hw_queue |= FIELD_PREP(MT_TX_HW_QUEUE_PHY, phy->band_idx);
+	}
+
+	return n;
+}
+
 static void
 mt76_queue_ps_skb(struct mt76_phy *phy, struct ieee80211_sta *sta,
 		  struct sk_buff *skb, bool last)
@@ -453,6 +471,23 @@ mt76_txq_stopped(struct mt76_queue *q)
 	       q->queued + MT_TXQ_FREE_THR >= q->ndesc;
 }
 
+/* DMA entries a frame can take at most, with two buffers per entry */
+#define MT_TX_FRAME_MAX_DESC \
+	DIV_ROUND_UP(ARRAY_SIZE(((struct mt76_tx_info *)0)->buf), 2)
+
+/* frames to take from mac80211 at once: as many as fit into the ring
+ * above the MT_TXQ_FREE_THR margin even if each needs the maximum number
+ * of entries, and never past the non-AQL limit
+ */
+static int
+mt76_txq_bulk_budget(struct mt76_queue *q, struct mt76_wcid *wcid)
+{
+	int free = q->ndesc - READ_ONCE(q->queued) - MT_TXQ_FREE_THR;
+
+	return min_t(int, free / MT_TX_FRAME_MAX_DESC,
+		     MT_MAX_NON_AQL_PKT - atomic_read(&wcid->non_aql_packets));
+}
+
 static int
 mt76_txq_send_burst(struct mt76_phy *phy, struct mt76_queue *q,
 		    struct mt76_txq *mtxq, struct mt76_wcid *wcid)
@@ -461,9 +496,11 @@ mt76_txq_send_burst(struct mt76_phy *phy, struct mt76_queue *q,
 	struct ieee80211_txq *txq = mtxq_to_txq(mtxq);
 	enum mt76_txq_id qid = mt76_txq_get_qid(txq);
 	struct ieee80211_tx_info *info;
+	struct sk_buff_head skbs;
 	struct sk_buff *skb;
 	int n_frames = 1;
 	bool stop = false;
+	int budget;
 	int idx;
 
 	if (test_bit(MT_WCID_FLAG_PS, &wcid->flags))
@@ -487,6 +524,7 @@ mt76_txq_send_burst(struct mt76_phy *phy, struct mt76_queue *q,
 	if (idx < 0)
 		return idx;
 
+	__skb_queue_head_init(&skbs);
 	do {
 		if (test_bit(MT76_RESET, &phy->state) || phy->offchannel)
 			break;
@@ -494,23 +532,42 @@ mt76_txq_send_burst(struct mt76_phy *phy, struct mt76_queue *q,
 		if (stop || mt76_txq_stopped(q))
 			break;
 
-		skb = mt76_txq_dequeue(phy, mtxq);
-		if (!skb)
+		budget = mt76_txq_bulk_budget(q, wcid);
+		if (budget <= 0)
 			break;
 
-		info = IEEE80211_SKB_CB(skb);
-		if (!(wcid->tx_info & MT_WCID_TX_INFO_SET))
-			ieee80211_get_tx_rates(txq->vif, txq->sta, skb,
-					       info->control.rates, 1);
+		if (!mt76_txq_dequeue_bulk(phy, mtxq, &skbs, budget))
+			break;
+
+		skb_queue_walk(&skbs, skb) {
+			info = IEEE80211_SKB_CB(skb);
+			if (!(wcid->tx_info & MT_WCID_TX_INFO_SET))
+				ieee80211_get_tx_rates(txq->vif, txq->sta, skb,
+						       info->control.rates, 1);
+		}
 
 		spin_lock(&q->lock);
-		idx = __mt76_tx_queue_skb(phy, qid, skb, wcid, txq->sta, &stop);
+		while ((skb = skb_peek(&skbs)) != NULL) {
+			if (test_bit(MT76_RESET, &phy->state) ||
+			    phy->offchannel || stop || mt76_txq_stopped(q))
+				break;
+
+			__skb_unlink(skb, &skbs);
+			idx = __mt76_tx_queue_skb(phy, qid, skb, wcid,
+						  txq->sta, &stop);
+			if (idx < 0)
+				break;
+
+			n_frames++;
+		}
 		spin_unlock(&q->lock);
-		if (idx < 0)
-			break;
+	} while (idx >= 0 && skb_queue_empty(&skbs));
 
-		n_frames++;
-	} while (1);
+	/* frames of the last batch that were not queued go back to mac80211
+	 * and are handed out first next time
+	 */
+	if (!skb_queue_empty(&skbs))
+		ieee80211_tx_requeue_bulk(phy->hw, txq, &skbs);
 
 	spin_lock(&q->lock);
 	dev->queue_ops->kick(dev, q);
@@ -1600,9 +1600,9 @@ struct ext4_sb_info {
 	unsigned int s_mb_order2_reqs;
 	unsigned int s_mb_group_prealloc;
 	unsigned int s_max_dir_size_kb;
-	/* where last allocation was done - for stream allocation */
-	unsigned long s_mb_last_group;
-	unsigned long s_mb_last_start;
+	/* where last allocations were done - for stream allocation */
+	ext4_group_t *s_mb_last_groups;
+	unsigned int s_mb_nr_global_goals;
 	unsigned int s_mb_prefetch;
 	unsigned int s_mb_prefetch_limit;
 	unsigned int s_mb_best_avail_max_trim_order;
@@ -1730,8 +1730,16 @@ struct ext4_sb_info {
 	unsigned int s_awu_min;
 	unsigned int s_awu_max;
 
-	/* Ext4 fast commit sub transaction ID */
-	atomic_t s_fc_subtid;
+	/*
+	 * Fast commit batching. Every fast commit takes the next ticket from
+	 * s_fc_started once it has begun, s_fc_ended counts the fast commits
+	 * that have finished (successfully or not) and s_fc_done is the
+	 * ticket of the last one that succeeded. All but s_fc_done are
+	 * protected by s_fc_lock.
+	 */
+	unsigned int s_fc_started;
+	unsigned int s_fc_ended;
+	unsigned int s_fc_done;
 
 	/*
 	 * After commit starts, the main queue gets locked, and the further
@@ -1753,6 +1761,9 @@ struct ext4_sb_info {
 	struct buffer_head *s_fc_bh;
 	struct ext4_fc_stats s_fc_stats;
 	tid_t s_fc_ineligible_tid;
+	int s_fc_ineligible_reason;	/* last reason fast commits were
+					 * marked ineligible for
+					 */
 #ifdef CONFIG_EXT4_DEBUG
 	int s_fc_debug_max_replay;
 #endif
@@ -3005,6 +3016,8 @@ extern int ext4_punch_hole(struct file *file, loff_t offset, loff_t length);
 extern void ext4_set_inode_flags(struct inode *, bool init);
 extern int ext4_alloc_da_blocks(struct inode *inode);
 extern void ext4_set_aops(struct inode *inode);
+extern void ext4_set_inode_mapping_order(struct inode *inode);
+extern int ext4_folio_trans_blocks(struct inode *, int nrblocks);
 extern int ext4_writepage_trans_blocks(struct inode *);
 extern int ext4_normal_submit_inode_data_buffers(struct jbd2_inode *jinode);
 extern int ext4_chunk_trans_blocks(struct inode *, int nrblocks);
@@ -3487,6 +3500,19 @@ static inline void ext4_lock_group(struct super_block *sb, ext4_group_t group)
 	}
 }
 
+static inline bool ext4_try_lock_group(struct super_block *sb,
+				       ext4_group_t group)
+{
+	if (!spin_trylock(ext4_group_lock_ptr(sb, group)))
+		return false;
+	/*
+	 * We're able to grab the lock right away, so drop the lock
+	 * contention counter.
+	 */
+	atomic_add_unless(&EXT4_SB(sb)->s_lock_busy, -1, 0);
+	return true;
+}
+
 static inline void ext4_unlock_group(struct super_block *sb,
 					ext4_group_t group)
 {
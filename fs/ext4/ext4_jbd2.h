@@ -14,6 +14,7 @@
 
 #include <linux/fs.h>
 #include <linux/jbd2.h>
+#include <linux/pagemap.h>
 #include "ext4.h"
 
 #define EXT4_JOURNAL(inode)	(EXT4_SB((inode)->i_sb)->s_journal)
@@ -410,6 +411,15 @@ static inline int ext4_journal_blocks_per_page(struct inode *inode)
 	return 0;
 }
 
+/* Blocks in the largest folio the page cache may use for @inode */
+static inline int ext4_journal_blocks_per_folio(struct inode *inode)
+{
+	if (EXT4_JOURNAL(inode) != NULL)
+		return mapping_max_folio_size(inode->i_mapping) >>
+			inode->i_blkbits;
+	return 0;
+}
+
 static inline int ext4_journal_force_commit(journal_t *journal)
 {
 	if (journal)
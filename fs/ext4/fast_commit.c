@@ -71,6 +71,17 @@
  * ext4_fc_mark_ineligible(): This makes next fast commit operation to fall back
  * to full commit.
  *
+ * Fast Commit Batching
+ * --------------------
+ *
+ * Only one fast commit runs at a time. Every fast commit takes a ticket once
+ * it has begun, and an fsync() remembers the ticket of the first fast commit
+ * that is certain to include its updates: the next one to begin, or the one
+ * after that if a fast commit is already running, since updates tracked
+ * meanwhile go to the staging queue. fsync() calls that arrive while a fast
+ * commit is running thus all wait for the same next commit, which one of them
+ * performs on behalf of the others.
+ *
  * Atomicity of commits
  * --------------------
  * In order to guarantee atomicity during the commit operation, fast commit
@@ -358,9 +369,10 @@ void ext4_fc_mark_ineligible(struct super_block *sb, int reason, handle_t *handl
 	if (has_transaction && (!is_ineligible || tid_gt(tid, sbi->s_fc_ineligible_tid)))
 		sbi->s_fc_ineligible_tid = tid;
 	ext4_set_mount_flag(sb, EXT4_MF_FC_INELIGIBLE);
-	spin_unlock(&sbi->s_fc_lock);
 	WARN_ON(reason >= EXT4_FC_REASON_MAX);
+	sbi->s_fc_ineligible_reason = reason;
 	sbi->s_fc_stats.fc_ineligible_reason_count[reason]++;
+	spin_unlock(&sbi->s_fc_lock);
 }
 
 /*
@@ -1170,13 +1182,41 @@ static void ext4_fc_update_stats(struct super_block *sb, int status,
 		   status == EXT4_FC_STATUS_INELIGIBLE) {
 		if (status == EXT4_FC_STATUS_FAILED)
 			stats->fc_failed_commits++;
+		else
+			stats->fc_ineligible_reason_commits[
+				READ_ONCE(EXT4_SB(sb)->s_fc_ineligible_reason)]++;
 		stats->fc_ineligible_commits++;
+	} else if (status == EXT4_FC_STATUS_BATCHED) {
+		stats->fc_batched_commits++;
 	} else {
 		stats->fc_skipped_commits++;
 	}
 	trace_ext4_fc_commit_stop(sb, nblks, status, commit_tid);
 }
 
+/*
+ * Return the ticket of the first fast commit that is guaranteed to pick up
+ * all the updates tracked so far. If a fast commit has begun in jbd2 but has
+ * not taken its ticket yet, updates may already be going to the staging
+ * queue, so skip that one as well. This is also what we see for the short
+ * window between a fast commit's cleanup and jbd2 clearing its ongoing flag,
+ * which only costs waiting for one extra commit.
+ */
+static unsigned int ext4_fc_next_ticket(struct super_block *sb)
+{
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	unsigned int ticket;
+
+	spin_lock(&sbi->s_fc_lock);
+	ticket = sbi->s_fc_started + 1;
+	if ((sbi->s_journal->j_flags & JBD2_FAST_COMMIT_ONGOING) &&
+	    sbi->s_fc_started == sbi->s_fc_ended)
+		ticket++;
+	spin_unlock(&sbi->s_fc_lock);
+
+	return ticket;
+}
+
 /*
  * The main commit entry point. Performs a fast commit for transaction
  * commit_tid if needed. If it's not possible to perform a fast commit
@@ -1188,8 +1228,8 @@ int ext4_fc_commit(journal_t *journal, tid_t commit_tid)
 	struct super_block *sb = journal->j_private;
 	struct ext4_sb_info *sbi = EXT4_SB(sb);
 	int nblks = 0, ret, bsize = journal->j_blocksize;
-	int subtid = atomic_read(&sbi->s_fc_subtid);
 	int status = EXT4_FC_STATUS_OK, fc_bufs_before = 0;
+	unsigned int wait_ticket, ticket;
 	ktime_t start_time, commit_time;
 
 	if (!test_opt2(sb, JOURNAL_FAST_COMMIT))
@@ -1198,17 +1238,24 @@ int ext4_fc_commit(journal_t *journal, tid_t commit_tid)
 	trace_ext4_fc_commit_start(sb, commit_tid);
 
 	start_time = ktime_get();
+	wait_ticket = ext4_fc_next_ticket(sb);
 
 restart_fc:
 	ret = jbd2_fc_begin_commit(journal, commit_tid);
 	if (ret == -EALREADY) {
-		/* There was an ongoing commit, check if we need to restart */
-		if (atomic_read(&sbi->s_fc_subtid) <= subtid &&
-		    tid_gt(commit_tid, journal->j_commit_sequence))
-			goto restart_fc;
-		ext4_fc_update_stats(sb, EXT4_FC_STATUS_SKIPPED, 0, 0,
-				commit_tid);
-		return 0;
+		/* A full commit has already covered this transaction */
+		if (!tid_gt(commit_tid, journal->j_commit_sequence)) {
+			ext4_fc_update_stats(sb, EXT4_FC_STATUS_SKIPPED, 0, 0,
+					     commit_tid);
+			return 0;
+		}
+		/* Another fsync's fast commit has picked up our updates */
+		if ((int)(READ_ONCE(sbi->s_fc_done) - wait_ticket) >= 0) {
+			ext4_fc_update_stats(sb, EXT4_FC_STATUS_BATCHED, 0, 0,
+					     commit_tid);
+			return 0;
+		}
+		goto restart_fc;
 	} else if (ret) {
 		/*
 		 * Commit couldn't start. Just update stats and perform a
@@ -1219,6 +1266,10 @@ int ext4_fc_commit(journal_t *journal, tid_t commit_tid)
 		return jbd2_complete_transaction(journal, commit_tid);
 	}
 
+	spin_lock(&sbi->s_fc_lock);
+	ticket = ++sbi->s_fc_started;
+	spin_unlock(&sbi->s_fc_lock);
+
 	/*
 	 * After establishing journal barrier via jbd2_fc_begin_commit(), check
 	 * if we are fast commit ineligible.
@@ -1240,7 +1291,8 @@ int ext4_fc_commit(journal_t *journal, tid_t commit_tid)
 		status = EXT4_FC_STATUS_FAILED;
 		goto fallback;
 	}
-	atomic_inc(&sbi->s_fc_subtid);
+	/* waiters are woken up by jbd2_fc_end_commit() */
+	WRITE_ONCE(sbi->s_fc_done, ticket);
 	ret = jbd2_fc_end_commit(journal);
 	/*
 	 * weight the commit time higher than the average time so we
@@ -1328,6 +1380,8 @@ static void ext4_fc_cleanup(journal_t *journal, int full, tid_t tid)
 
 	if (full)
 		sbi->s_fc_bytes = 0;
+	else
+		sbi->s_fc_ended++;
 	spin_unlock(&sbi->s_fc_lock);
 	trace_ext4_fc_stats(sb);
 }
@@ -2290,10 +2344,17 @@ int ext4_fc_info_show(struct seq_file *seq, void *v)
 		   stats->fc_num_commits, stats->fc_ineligible_commits,
 		   stats->fc_numblks,
 		   div_u64(stats->s_fc_avg_commit_time, 1000));
+	seq_printf(seq, "%ld failed\n%ld skipped\n%ld batched\n",
+		   stats->fc_failed_commits, stats->fc_skipped_commits,
+		   stats->fc_batched_commits);
 	seq_puts(seq, "Ineligible reasons:\n");
 	for (i = 0; i < EXT4_FC_REASON_MAX; i++)
 		seq_printf(seq, "\"%s\":\t%d\n", fc_ineligible_reasons[i],
 			stats->fc_ineligible_reason_count[i]);
+	seq_puts(seq, "Ineligible commits by reason:\n");
+	for (i = 0; i < EXT4_FC_REASON_MAX; i++)
+		seq_printf(seq, "\"%s\":\t%ld\n", fc_ineligible_reasons[i],
+			stats->fc_ineligible_reason_commits[i]);
 
 	return 0;
 }
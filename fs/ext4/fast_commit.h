@@ -81,6 +81,7 @@ enum {
 	EXT4_FC_STATUS_INELIGIBLE,
 	EXT4_FC_STATUS_SKIPPED,
 	EXT4_FC_STATUS_FAILED,
+	EXT4_FC_STATUS_BATCHED,
 };
 
 /*
@@ -116,10 +117,13 @@ struct ext4_fc_dentry_update {
 
 struct ext4_fc_stats {
 	unsigned int fc_ineligible_reason_count[EXT4_FC_REASON_MAX];
+	/* full commit fallbacks, by the reason that forced them */
+	unsigned long fc_ineligible_reason_commits[EXT4_FC_REASON_MAX];
 	unsigned long fc_num_commits;
 	unsigned long fc_ineligible_commits;
 	unsigned long fc_failed_commits;
 	unsigned long fc_skipped_commits;
+	unsigned long fc_batched_commits;
 	unsigned long fc_numblks;
 	u64 s_fc_avg_commit_time;
 };
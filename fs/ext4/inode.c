@@ -1023,8 +1023,8 @@ int ext4_block_write_begin(handle_t *handle, struct folio *folio,
 			   loff_t pos, unsigned len,
 			   get_block_t *get_block)
 {
-	unsigned from = pos & (PAGE_SIZE - 1);
-	unsigned to = from + len;
+	unsigned int from = offset_in_folio(folio, pos);
+	unsigned int to = from + len;
 	struct inode *inode = folio->mapping->host;
 	unsigned block_start, block_end;
 	sector_t block;
@@ -1037,15 +1037,14 @@ int ext4_block_write_begin(handle_t *handle, struct folio *folio,
 	bool should_journal_data = ext4_should_journal_data(inode);
 
 	BUG_ON(!folio_test_locked(folio));
-	BUG_ON(from > PAGE_SIZE);
-	BUG_ON(to > PAGE_SIZE);
+	BUG_ON(to > folio_size(folio));
 	BUG_ON(from > to);
 
 	head = folio_buffers(folio);
 	if (!head)
 		head = create_empty_buffers(folio, blocksize, 0);
 	bbits = ilog2(blocksize);
-	block = (sector_t)folio->index << (PAGE_SHIFT - bbits);
+	block = folio_pos(folio) >> bbits;
 
 	for (bh = head, block_start = 0; bh != head || !block_start;
 	    block++, block_start = block_end, bh = bh->b_this_page) {
@@ -1153,14 +1152,7 @@ static int ext4_write_begin(struct file *file, struct address_space *mapping,
 		return -EIO;
 
 	trace_ext4_write_begin(inode, pos, len);
-	/*
-	 * Reserve one block more for addition to orphan list in case
-	 * we allocate blocks but write fails for some reason
-	 */
-	needed_blocks = ext4_writepage_trans_blocks(inode) + 1;
 	index = pos >> PAGE_SHIFT;
-	from = pos & (PAGE_SIZE - 1);
-	to = from + len;
 
 	if (ext4_test_inode_state(inode, EXT4_STATE_MAY_INLINE_DATA)) {
 		ret = ext4_try_to_write_inline_data(mapping, inode, pos, len,
@@ -1179,10 +1171,28 @@ static int ext4_write_begin(struct file *file, struct address_space *mapping,
 	 * the folio (if needed) without using GFP_NOFS.
 	 */
 retry_grab:
-	folio = __filemap_get_folio(mapping, index, FGP_WRITEBEGIN,
-					mapping_gfp_mask(mapping));
+	folio = __filemap_get_folio(mapping, index,
+				    FGP_WRITEBEGIN | fgf_set_order(len),
+				    mapping_gfp_mask(mapping));
 	if (IS_ERR(folio))
 		return PTR_ERR(folio);
+
+	/* The write may extend past the end of a large folio */
+	if (pos + len > folio_pos(folio) + folio_size(folio))
+		len = folio_pos(folio) + folio_size(folio) - pos;
+	from = offset_in_folio(folio, pos);
+	to = from + len;
+
+	/*
+	 * Only the blocks under the write get allocated, size the credits
+	 * for those rather than for the whole folio. Reserve one block more
+	 * for addition to orphan list in case we allocate blocks but write
+	 * fails for some reason.
+	 */
+	needed_blocks = ext4_folio_trans_blocks(inode,
+			((pos + len - 1) >> inode->i_blkbits) -
+			(pos >> inode->i_blkbits) + 1) + 1;
+
 	/*
 	 * The same as page allocation, we prealloc buffer heads before
 	 * starting the handle.
@@ -1578,7 +1588,7 @@ static void mpage_release_unused_pages(struct mpage_da_data *mpd,
 	if (invalidate) {
 		ext4_lblk_t start, last;
 		start = index << (PAGE_SHIFT - inode->i_blkbits);
-		last = end << (PAGE_SHIFT - inode->i_blkbits);
+		last = ((end + 1) << (PAGE_SHIFT - inode->i_blkbits)) - 1;
 
 		/*
 		 * avoid racing with extent status tree scans made by
@@ -1931,7 +1941,7 @@ static int mpage_submit_folio(struct mpage_da_data *mpd, struct folio *folio)
 		len = size & (len - 1);
 	err = ext4_bio_write_folio(&mpd->io_submit, folio, len);
 	if (!err)
-		mpd->wbc->nr_to_write--;
+		mpd->wbc->nr_to_write -= folio_nr_pages(folio);
 
 	return err;
 }
@@ -2154,7 +2164,6 @@ static int mpage_map_and_submit_buffers(struct mpage_da_data *mpd)
 
 	start = mpd->map.m_lblk >> bpp_bits;
 	end = (mpd->map.m_lblk + mpd->map.m_len - 1) >> bpp_bits;
-	lblk = start << bpp_bits;
 	pblock = mpd->map.m_pblk;
 
 	folio_batch_init(&fbatch);
@@ -2165,6 +2174,8 @@ static int mpage_map_and_submit_buffers(struct mpage_da_data *mpd)
 		for (i = 0; i < nr; i++) {
 			struct folio *folio = fbatch.folios[i];
 
+			/* A large folio may start before the extent */
+			lblk = folio->index << bpp_bits;
 			err = mpage_process_folio(mpd, folio, &lblk, &pblock,
 						 &map_bh);
 			/*
@@ -2345,15 +2356,17 @@ static int mpage_map_and_submit_extent(handle_t *handle,
  * Calculate the total number of credits to reserve for one writepages
  * iteration. This is called from ext4_writepages(). We map an extent of
  * up to MAX_WRITEPAGES_EXTENT_LEN blocks and then we go on and finish mapping
- * the last partial page. So in total we can map MAX_WRITEPAGES_EXTENT_LEN +
- * bpp - 1 blocks in bpp different extents.
+ * the last partial folio. So in total we can map MAX_WRITEPAGES_EXTENT_LEN +
+ * bpf - 1 blocks in bpf different extents. A folio cannot be mapped across
+ * transactions, so this has to cover the largest folio of the mapping; it is
+ * taken once per iteration, not once per folio.
  */
 static int ext4_da_writepages_trans_blocks(struct inode *inode)
 {
-	int bpp = ext4_journal_blocks_per_page(inode);
+	int bpf = ext4_journal_blocks_per_folio(inode);
 
 	return ext4_meta_trans_blocks(inode,
-				MAX_WRITEPAGES_EXTENT_LEN + bpp - 1, bpp);
+				MAX_WRITEPAGES_EXTENT_LEN + bpf - 1, bpf);
 }
 
 static int ext4_journal_folio_buffers(handle_t *handle, struct folio *folio,
@@ -2938,11 +2951,15 @@ static int ext4_da_write_begin(struct file *file, struct address_space *mapping,
 	}
 
 retry:
-	folio = __filemap_get_folio(mapping, index, FGP_WRITEBEGIN,
-			mapping_gfp_mask(mapping));
+	folio = __filemap_get_folio(mapping, index,
+				    FGP_WRITEBEGIN | fgf_set_order(len),
+				    mapping_gfp_mask(mapping));
 	if (IS_ERR(folio))
 		return PTR_ERR(folio);
 
+	if (pos + len > folio_pos(folio) + folio_size(folio))
+		len = folio_pos(folio) + folio_size(folio) - pos;
+
 	ret = ext4_block_write_begin(NULL, folio, pos, len,
 				     ext4_da_get_block_prep);
 	if (ret < 0) {
@@ -3031,7 +3048,7 @@ static int ext4_da_do_write_end(struct address_space *mapping,
 		unsigned long end;
 
 		i_size_write(inode, new_i_size);
-		end = (new_i_size - 1) & (PAGE_SIZE - 1);
+		end = offset_in_folio(folio, new_i_size - 1);
 		if (copied && ext4_da_should_update_i_disksize(folio, end)) {
 			ext4_update_i_disksize(inode, new_i_size);
 			disksize_changed = true;
@@ -3650,6 +3667,40 @@ static const struct address_space_operations ext4_dax_aops = {
 	.swap_activate		= ext4_iomap_swap_activate,
 };
 
+/*
+ * Large folios are only used on the ordered and writeback data paths. The
+ * data=journal, encryption, verity and inline data code still expects a
+ * folio per page.
+ */
+static bool ext4_should_enable_large_folio(struct inode *inode)
+{
+	struct super_block *sb = inode->i_sb;
+
+	if (!S_ISREG(inode->i_mode) || IS_DAX(inode))
+		return false;
+	if (ext4_should_journal_data(inode))
+		return false;
+	if (ext4_has_feature_encrypt(sb) || ext4_has_feature_verity(sb) ||
+	    ext4_has_feature_inline_data(sb))
+		return false;
+	return true;
+}
+
+/*
+ * Bound folios to 2^EXT4_MAX_FOLIO_BLOCKS_BITS blocks, so that the journal
+ * credits reserved for writing one folio stay small.
+ */
+#define EXT4_MAX_FOLIO_BLOCKS_BITS	6
+
+void ext4_set_inode_mapping_order(struct inode *inode)
+{
+	int order = EXT4_MAX_FOLIO_BLOCKS_BITS + inode->i_blkbits - PAGE_SHIFT;
+
+	if (order < 0 || !ext4_should_enable_large_folio(inode))
+		order = 0;
+	mapping_set_folio_order_range(inode->i_mapping, 0, order);
+}
+
 void ext4_set_aops(struct inode *inode)
 {
 	switch (ext4_inode_journal_mode(inode)) {
@@ -3679,8 +3730,7 @@ void ext4_set_aops(struct inode *inode)
 static int __ext4_block_zero_page_range(handle_t *handle,
 		struct address_space *mapping, loff_t from, loff_t length)
 {
-	ext4_fsblk_t index = from >> PAGE_SHIFT;
-	unsigned offset = from & (PAGE_SIZE-1);
+	unsigned int offset;
 	unsigned blocksize, pos;
 	ext4_lblk_t iblock;
 	struct inode *inode = mapping->host;
@@ -3696,7 +3746,8 @@ static int __ext4_block_zero_page_range(handle_t *handle,
 
 	blocksize = inode->i_sb->s_blocksize;
 
-	iblock = index << (PAGE_SHIFT - inode->i_sb->s_blocksize_bits);
+	offset = offset_in_folio(folio, from);
+	iblock = folio_pos(folio) >> inode->i_sb->s_blocksize_bits;
 
 	bh = folio_buffers(folio);
 	if (!bh)
@@ -4991,6 +5042,7 @@ struct inode *__ext4_iget(struct super_block *sb, unsigned long ino,
 		inode->i_op = &ext4_file_inode_operations;
 		inode->i_fop = &ext4_file_operations;
 		ext4_set_aops(inode);
+		ext4_set_inode_mapping_order(inode);
 	} else if (S_ISDIR(inode->i_mode)) {
 		inode->i_op = &ext4_dir_inode_operations;
 		inode->i_fop = &ext4_dir_operations;
@@ -5751,28 +5803,37 @@ static int ext4_meta_trans_blocks(struct inode *inode, int lblocks,
 }
 
 /*
- * Calculate the total number of credits to reserve to fit
- * the modification of a single pages into a single transaction,
- * which may include multiple chunks of block allocations.
+ * Calculate the total number of credits to reserve to fit the
+ * modification of @nrblocks blocks of a single folio into a single
+ * transaction, which may include multiple chunks of block allocations.
  *
- * This could be called via ext4_write_begin()
+ * This could be called via ext4_write_begin() or ext4_page_mkwrite()
  *
  * We need to consider the worse case, when
  * one new block per extent.
  */
-int ext4_writepage_trans_blocks(struct inode *inode)
+int ext4_folio_trans_blocks(struct inode *inode, int nrblocks)
 {
-	int bpp = ext4_journal_blocks_per_page(inode);
 	int ret;
 
-	ret = ext4_meta_trans_blocks(inode, bpp, bpp);
+	ret = ext4_meta_trans_blocks(inode, nrblocks, nrblocks);
 
 	/* Account for data blocks for journalled mode */
 	if (ext4_should_journal_data(inode))
-		ret += bpp;
+		ret += nrblocks;
 	return ret;
 }
 
+/*
+ * Calculate the total number of credits to reserve to fit
+ * the modification of a single page into a single transaction.
+ */
+int ext4_writepage_trans_blocks(struct inode *inode)
+{
+	return ext4_folio_trans_blocks(inode,
+				       ext4_journal_blocks_per_page(inode));
+}
+
 /*
  * Calculate the journal credits for a chunk of data modification.
  *
@@ -6084,6 +6145,9 @@ int ext4_change_inode_journal_flag(struct inode *inode, int val)
 			filemap_invalidate_unlock(inode->i_mapping);
 			return err;
 		}
+		/* The journalled aops can't handle large folios */
+		if (mapping_large_folio_support(inode->i_mapping))
+			truncate_pagecache(inode, 0);
 	}
 
 	alloc_ctx = ext4_writepages_down_write(inode->i_sb);
@@ -6097,9 +6161,9 @@ int ext4_change_inode_journal_flag(struct inode *inode, int val)
 	 * the inode's in-core data-journaling state flag now.
 	 */
 
-	if (val)
+	if (val) {
 		ext4_set_inode_flag(inode, EXT4_INODE_JOURNAL_DATA);
-	else {
+	} else {
 		err = jbd2_journal_flush(journal, 0);
 		if (err < 0) {
 			jbd2_journal_unlock_updates(journal);
@@ -6109,6 +6173,7 @@ int ext4_change_inode_journal_flag(struct inode *inode, int val)
 		ext4_clear_inode_flag(inode, EXT4_INODE_JOURNAL_DATA);
 	}
 	ext4_set_aops(inode);
+	ext4_set_inode_mapping_order(inode);
 
 	jbd2_journal_unlock_updates(journal);
 	ext4_writepages_up_write(inode->i_sb, alloc_ctx);
@@ -6222,7 +6287,8 @@ vm_fault_t ext4_page_mkwrite(struct vm_fault *vmf)
 		get_block = ext4_get_block;
 retry_alloc:
 	handle = ext4_journal_start(inode, EXT4_HT_WRITE_PAGE,
-				    ext4_writepage_trans_blocks(inode));
+			ext4_folio_trans_blocks(inode,
+				folio_size(folio) >> inode->i_blkbits));
 	if (IS_ERR(handle)) {
 		ret = VM_FAULT_SIGBUS;
 		goto out;
@@ -5,6 +5,7 @@
 
 #include <kunit/test.h>
 #include <kunit/static_stub.h>
+#include <linux/kthread.h>
 #include <linux/random.h>
 
 #include "ext4.h"
@@ -933,6 +934,205 @@ static void test_mb_mark_used_cost(struct kunit *test)
 	ext4_mb_unload_buddy(&e4b);
 }
 
+static void test_mb_stream_goal(struct kunit *test)
+{
+	struct super_block *sb = (struct super_block *)test->priv;
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	ext4_group_t ngroups = ext4_get_groups_count(sb);
+	struct ext4_allocation_context ac = {};
+	ext4_group_t *goal, *first = NULL;
+	bool spread = false;
+	struct inode *inode;
+	unsigned long ino;
+
+	inode = kunit_kzalloc(test, sizeof(*inode), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, inode);
+
+	KUNIT_ASSERT_EQ(test, sbi->s_mb_nr_global_goals, num_possible_cpus());
+
+	inode->i_sb = sb;
+	ac.ac_sb = sb;
+	ac.ac_inode = inode;
+	for (ino = 1; ino <= 64; ino++) {
+		inode->i_ino = ino;
+		goal = ext4_mb_stream_goal(&ac);
+		KUNIT_ASSERT_TRUE(test, goal >= sbi->s_mb_last_groups);
+		KUNIT_ASSERT_TRUE(test, goal < sbi->s_mb_last_groups +
+					      sbi->s_mb_nr_global_goals);
+		/* the same inode must keep seeing the goal it stored */
+		WRITE_ONCE(*goal, ino % ngroups);
+		KUNIT_ASSERT_EQ(test, READ_ONCE(*ext4_mb_stream_goal(&ac)),
+				ino % ngroups);
+
+		if (!first)
+			first = goal;
+		else if (goal != first)
+			spread = true;
+	}
+
+	if (sbi->s_mb_nr_global_goals > 1)
+		KUNIT_ASSERT_TRUE_MSG(test, spread,
+			"all inodes share a single stream goal");
+}
+
+#define MBT_MAX_WORKERS TEST_RANGE_COUNT
+#define MBT_WORKER_INFLIGHT 8
+#define MBT_WORKER_MAX_LEN 8
+#define COUNT_FOR_CONCURRENT_ESTIMATE 10000
+
+struct mbt_worker {
+	struct kunit *test;
+	struct super_block *sb;
+	struct ext4_inode_info *ei;
+	int err;
+	unsigned long jiffies;
+	struct completion done;
+};
+
+static void mbt_worker_free(struct super_block *sb,
+			    struct ext4_free_extent *ex)
+{
+	struct ext4_buddy e4b;
+
+	if (!ex->fe_len)
+		return;
+
+	if (!ext4_mb_load_buddy(sb, ex->fe_group, &e4b)) {
+		ext4_lock_group(sb, ex->fe_group);
+		mb_free_blocks(NULL, &e4b, ex->fe_start, ex->fe_len);
+		ext4_unlock_group(sb, ex->fe_group);
+		ext4_mb_unload_buddy(&e4b);
+	}
+	ex->fe_len = 0;
+}
+
+/*
+ * Each worker does stream allocations through the regular allocator, so
+ * they start from the worker's stream goal and take the group locks the
+ * way real writers do. A few extents are kept allocated at any time to
+ * leave the groups partly used.
+ */
+static int mbt_regular_alloc_worker(void *data)
+{
+	struct mbt_worker *w = data;
+	struct super_block *sb = w->sb;
+	struct ext4_free_extent held[MBT_WORKER_INFLIGHT] = {};
+	struct ext4_allocation_context ac;
+	unsigned long start;
+	int i;
+
+	/* static stubs are looked up through the current test */
+	current->kunit_test = w->test;
+
+	start = jiffies;
+	for (i = 0; i < COUNT_FOR_CONCURRENT_ESTIMATE; i++) {
+		struct ext4_free_extent *ex = &held[i % MBT_WORKER_INFLIGHT];
+
+		mbt_worker_free(sb, ex);
+
+		memset(&ac, 0, sizeof(ac));
+		ac.ac_sb = sb;
+		ac.ac_inode = &w->ei->vfs_inode;
+		ac.ac_status = AC_STATUS_CONTINUE;
+		ac.ac_flags = EXT4_MB_STREAM_ALLOC;
+		ac.ac_o_ex.fe_len = get_random_u32() % MBT_WORKER_MAX_LEN + 1;
+		ac.ac_g_ex = ac.ac_o_ex;
+		ac.ac_orig_goal_len = ac.ac_g_ex.fe_len;
+
+		w->err = ext4_mb_regular_allocator(&ac);
+		if (!w->err && ac.ac_status != AC_STATUS_FOUND)
+			w->err = -ENOSPC;
+		if (w->err)
+			break;
+
+		folio_put(ac.ac_bitmap_folio);
+		folio_put(ac.ac_buddy_folio);
+		*ex = ac.ac_f_ex;
+	}
+	w->jiffies = jiffies - start;
+
+	for (i = 0; i < MBT_WORKER_INFLIGHT; i++)
+		mbt_worker_free(sb, &held[i]);
+
+	current->kunit_test = NULL;
+	complete(&w->done);
+	return 0;
+}
+
+static unsigned long mbt_run_workers(struct kunit *test, struct mbt_worker *w,
+				     int nr, bool per_inode)
+{
+	struct super_block *sb = (struct super_block *)test->priv;
+	struct task_struct *task;
+	unsigned long all = 0;
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		w[i].test = test;
+		w[i].sb = sb;
+		/* inodes with the same number share a stream goal */
+		w[i].ei->vfs_inode.i_ino = per_inode ? i + 1 : 1;
+		w[i].err = 0;
+		w[i].jiffies = 0;
+		init_completion(&w[i].done);
+		task = kthread_run(mbt_regular_alloc_worker, &w[i],
+				   "mbt_worker/%d", i);
+		if (IS_ERR(task)) {
+			w[i].err = PTR_ERR(task);
+			complete(&w[i].done);
+		}
+	}
+
+	for (i = 0; i < nr; i++) {
+		wait_for_completion(&w[i].done);
+		KUNIT_EXPECT_EQ(test, w[i].err, 0);
+		all += w[i].jiffies;
+	}
+
+	return all;
+}
+
+static void test_mb_regular_allocator_concurrent_cost(struct kunit *test)
+{
+	struct super_block *sb = (struct super_block *)test->priv;
+	unsigned long shared, per_inode;
+	struct mbt_worker *w;
+	struct ext4_buddy e4b;
+	ext4_group_t i;
+	int nr, ret, j;
+
+	/* buddy cache assumes that each page contains at least one block */
+	if (sb->s_blocksize > PAGE_SIZE)
+		kunit_skip(test, "blocksize exceeds pagesize");
+
+	nr = min_t(int, num_online_cpus(), MBT_MAX_WORKERS);
+	if (nr < 2)
+		kunit_skip(test, "needs at least two online CPUs");
+
+	w = kunit_kcalloc(test, nr, sizeof(*w), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, w);
+	for (j = 0; j < nr; j++) {
+		w[j].ei = kunit_kzalloc(test, sizeof(*w[j].ei), GFP_KERNEL);
+		KUNIT_ASSERT_NOT_NULL(test, w[j].ei);
+		w[j].ei->vfs_inode.i_sb = sb;
+		/* block mapped files only scan s_blockfile_groups */
+		ext4_set_inode_flag(&w[j].ei->vfs_inode, EXT4_INODE_EXTENTS);
+	}
+
+	/* initialize the buddy of every group before the workers race on it */
+	for (i = 0; i < ext4_get_groups_count(sb); i++) {
+		ret = ext4_mb_load_buddy(sb, i, &e4b);
+		KUNIT_ASSERT_EQ(test, ret, 0);
+		ext4_mb_unload_buddy(&e4b);
+	}
+
+	shared = mbt_run_workers(test, w, nr, false);
+	per_inode = mbt_run_workers(test, w, nr, true);
+
+	kunit_info(test, "%d workers costed jiffies %lu sharing one stream goal, %lu with per-inode goals\n",
+		   nr, shared, per_inode);
+}
+
 static const struct mbt_ext4_block_layout mbt_test_layouts[] = {
 	{
 		.blocksize_bits = 10,
@@ -977,6 +1177,10 @@ static struct kunit_case mbt_test_cases[] = {
 	KUNIT_CASE_PARAM(test_mark_diskspace_used, mbt_layouts_gen_params),
 	KUNIT_CASE_PARAM_ATTR(test_mb_mark_used_cost, mbt_layouts_gen_params,
 			      { .speed = KUNIT_SPEED_SLOW }),
+	KUNIT_CASE_PARAM(test_mb_stream_goal, mbt_layouts_gen_params),
+	KUNIT_CASE_PARAM_ATTR(test_mb_regular_allocator_concurrent_cost,
+			      mbt_layouts_gen_params,
+			      { .speed = KUNIT_SPEED_SLOW }),
 	{}
 };
 
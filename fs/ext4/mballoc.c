@@ -17,6 +17,7 @@
 #include <linux/nospec.h>
 #include <linux/backing-dev.h>
 #include <linux/freezer.h>
+#include <linux/hash.h>
 #include <trace/events/ext4.h>
 #include <kunit/static_stub.h>
 
@@ -2130,13 +2131,28 @@ static int mb_mark_used(struct ext4_buddy *e4b, struct ext4_free_extent *ex)
 	return ret;
 }
 
+/*
+ * Stream allocations start scanning from the group the previous stream
+ * allocation ended up in. There is one such goal per possible CPU and the
+ * slot is picked by inode number, so concurrent writers to different files
+ * spread over several groups instead of all contending on the same one,
+ * while each file still keeps a stable goal. Goals are only hints, hence
+ * they are read and updated without any locking.
+ */
+static ext4_group_t *ext4_mb_stream_goal(struct ext4_allocation_context *ac)
+{
+	struct ext4_sb_info *sbi = EXT4_SB(ac->ac_sb);
+	u32 hash = hash_long(ac->ac_inode->i_ino, 32);
+
+	return &sbi->s_mb_last_groups[hash % sbi->s_mb_nr_global_goals];
+}
+
 /*
  * Must be called under group lock!
  */
 static void ext4_mb_use_best_found(struct ext4_allocation_context *ac,
 					struct ext4_buddy *e4b)
 {
-	struct ext4_sb_info *sbi = EXT4_SB(ac->ac_sb);
 	int ret;
 
 	BUG_ON(ac->ac_b_ex.fe_group != e4b->bd_group);
@@ -2166,12 +2182,8 @@ static void ext4_mb_use_best_found(struct ext4_allocation_context *ac,
 	ac->ac_buddy_folio = e4b->bd_buddy_folio;
 	folio_get(ac->ac_buddy_folio);
 	/* store last allocated for subsequent stream allocation */
-	if (ac->ac_flags & EXT4_MB_STREAM_ALLOC) {
-		spin_lock(&sbi->s_md_lock);
-		sbi->s_mb_last_group = ac->ac_f_ex.fe_group;
-		sbi->s_mb_last_start = ac->ac_f_ex.fe_start;
-		spin_unlock(&sbi->s_md_lock);
-	}
+	if (ac->ac_flags & EXT4_MB_STREAM_ALLOC)
+		WRITE_ONCE(*ext4_mb_stream_goal(ac), ac->ac_f_ex.fe_group);
 	/*
 	 * As we've just preallocated more space than
 	 * user requested originally, we store allocated
@@ -2588,11 +2600,12 @@ static bool ext4_mb_good_group(struct ext4_allocation_context *ac,
 	if (unlikely(!grp || EXT4_MB_GRP_BBITMAP_CORRUPT(grp)))
 		return false;
 
-	free = grp->bb_free;
+	/* may be called without the group lock, see ext4_mb_good_group_nolock */
+	free = READ_ONCE(grp->bb_free);
 	if (free == 0)
 		return false;
 
-	fragments = grp->bb_fragments;
+	fragments = READ_ONCE(grp->bb_fragments);
 	if (fragments == 0)
 		return false;
 
@@ -2612,7 +2625,7 @@ static bool ext4_mb_good_group(struct ext4_allocation_context *ac,
 		if (ac->ac_2order >= MB_NUM_ORDERS(ac->ac_sb))
 			return true;
 
-		if (grp->bb_largest_free_order < ac->ac_2order)
+		if (READ_ONCE(grp->bb_largest_free_order) < ac->ac_2order)
 			return false;
 
 		return true;
@@ -2663,7 +2676,7 @@ static int ext4_mb_good_group_nolock(struct ext4_allocation_context *ac,
 		ext4_lock_group(sb, group);
 		__release(ext4_group_lock_ptr(sb, group));
 	}
-	free = grp->bb_free;
+	free = READ_ONCE(grp->bb_free);
 	if (free == 0)
 		goto out;
 	/*
@@ -2844,11 +2857,9 @@ ext4_mb_regular_allocator(struct ext4_allocation_context *ac)
 
 	/* if stream allocation is enabled, use global goal */
 	if (ac->ac_flags & EXT4_MB_STREAM_ALLOC) {
-		/* TBD: may be hot point */
-		spin_lock(&sbi->s_md_lock);
-		ac->ac_g_ex.fe_group = sbi->s_mb_last_group;
-		ac->ac_g_ex.fe_start = sbi->s_mb_last_start;
-		spin_unlock(&sbi->s_md_lock);
+		group = READ_ONCE(*ext4_mb_stream_goal(ac));
+		/* the goal may come from a file allowed to use more groups */
+		ac->ac_g_ex.fe_group = group < ngroups ? group : 0;
 	}
 
 	/*
@@ -2911,7 +2922,21 @@ ext4_mb_regular_allocator(struct ext4_allocation_context *ac)
 			if (err)
 				goto out;
 
-			ext4_lock_group(sb, group);
+			/*
+			 * At the cheap criteria there are plenty of other
+			 * candidates, so rather than queue up behind another
+			 * allocator move on to the next group. The expensive
+			 * criteria still wait, so a busy group is never
+			 * missed for good.
+			 */
+			if (!ext4_mb_cr_expensive(cr)) {
+				if (!ext4_try_lock_group(sb, group)) {
+					ext4_mb_unload_buddy(&e4b);
+					continue;
+				}
+			} else {
+				ext4_lock_group(sb, group);
+			}
 
 			/*
 			 * We need to check again after locking the
@@ -3669,6 +3694,14 @@ int ext4_mb_init(struct super_block *sb)
 		rwlock_init(&sbi->s_mb_largest_free_orders_locks[i]);
 	}
 
+	sbi->s_mb_nr_global_goals = num_possible_cpus();
+	sbi->s_mb_last_groups = kcalloc(sbi->s_mb_nr_global_goals,
+					sizeof(ext4_group_t), GFP_KERNEL);
+	if (!sbi->s_mb_last_groups) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
 	spin_lock_init(&sbi->s_md_lock);
 	sbi->s_mb_free_pending = 0;
 	INIT_LIST_HEAD(&sbi->s_freed_data_list[0]);
@@ -3740,6 +3773,8 @@ int ext4_mb_init(struct super_block *sb)
 	free_percpu(sbi->s_locality_groups);
 	sbi->s_locality_groups = NULL;
 out:
+	kfree(sbi->s_mb_last_groups);
+	sbi->s_mb_last_groups = NULL;
 	kfree(sbi->s_mb_avg_fragment_size);
 	kfree(sbi->s_mb_avg_fragment_size_locks);
 	kfree(sbi->s_mb_largest_free_orders);
@@ -3810,6 +3845,7 @@ void ext4_mb_release(struct super_block *sb)
 		kvfree(group_info);
 		rcu_read_unlock();
 	}
+	kfree(sbi->s_mb_last_groups);
 	kfree(sbi->s_mb_avg_fragment_size);
 	kfree(sbi->s_mb_avg_fragment_size_locks);
 	kfree(sbi->s_mb_largest_free_orders);
@@ -324,9 +324,14 @@ move_extent_per_page(struct file *o_filp, struct inode *donor_inode,
 	 * necessary, just swap data blocks between orig and donor.
 	 */
 
-	VM_BUG_ON_FOLIO(folio_test_large(folio[0]), folio[0]);
-	VM_BUG_ON_FOLIO(folio_test_large(folio[1]), folio[1]);
-	VM_BUG_ON_FOLIO(folio_nr_pages(folio[0]) != folio_nr_pages(folio[1]), folio[1]);
+	/*
+	 * Large folios were dropped by ext4_move_extents(), but a racing
+	 * read may have brought one back.
+	 */
+	if (folio_test_large(folio[0]) || folio_test_large(folio[1])) {
+		*err = -EBUSY;
+		goto unlock_folios;
+	}
 
 	if (unwritten) {
 		ext4_double_down_write_data_sem(orig_inode, donor_inode);
@@ -546,6 +551,31 @@ mext_check_arguments(struct inode *orig_inode,
 	return 0;
 }
 
+/**
+ * mext_drop_large_folios - Write back and drop cached large folios
+ *
+ * @inode:	inode whose page cache to drop
+ * @lblk:	logical block to start from
+ *
+ * Data is moved a page at a time by move_extent_per_page(), which can't
+ * work on a large folio, so drop the page cache from @lblk to the end of
+ * the file. Return 0 on success, or a negative error value.
+ */
+static int mext_drop_large_folios(struct inode *inode, ext4_lblk_t lblk)
+{
+	struct address_space *mapping = inode->i_mapping;
+	loff_t start = (loff_t)lblk << inode->i_blkbits;
+	int ret;
+
+	if (!mapping_large_folio_support(mapping))
+		return 0;
+
+	ret = filemap_write_and_wait_range(mapping, start, LLONG_MAX);
+	if (ret)
+		return ret;
+	return invalidate_inode_pages2_range(mapping, start >> PAGE_SHIFT, -1);
+}
+
 /**
  * ext4_move_extents - Exchange the specified range of a file
  *
@@ -617,6 +647,14 @@ ext4_move_extents(struct file *o_filp, struct file *d_filp, __u64 orig_blk,
 	inode_dio_wait(orig_inode);
 	inode_dio_wait(donor_inode);
 
+	ret = mext_drop_large_folios(orig_inode, orig_blk);
+	if (!ret)
+		ret = mext_drop_large_folios(donor_inode, donor_blk);
+	if (ret) {
+		unlock_two_nondirectories(orig_inode, donor_inode);
+		return ret;
+	}
+
 	/* Protect extent tree against block allocations via delalloc */
 	ext4_double_down_write_data_sem(orig_inode, donor_inode);
 	/* Check the filesystem environment whether move_extent can be done */
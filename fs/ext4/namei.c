@@ -2846,6 +2846,7 @@ static int ext4_create(struct mnt_idmap *idmap, struct inode *dir,
 		inode->i_op = &ext4_file_inode_operations;
 		inode->i_fop = &ext4_file_operations;
 		ext4_set_aops(inode);
+		ext4_set_inode_mapping_order(inode);
 		err = ext4_add_nondir(handle, dentry, &inode);
 		if (!err)
 			ext4_fc_track_create(handle, dentry);
@@ -2916,6 +2917,7 @@ static int ext4_tmpfile(struct mnt_idmap *idmap, struct inode *dir,
 		inode->i_op = &ext4_file_inode_operations;
 		inode->i_fop = &ext4_file_operations;
 		ext4_set_aops(inode);
+		ext4_set_inode_mapping_order(inode);
 		d_tmpfile(file, inode);
 		err = ext4_orphan_add(handle, inode);
 		if (err)
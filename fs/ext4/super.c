@@ -4474,7 +4474,9 @@ static void ext4_fast_commit_init(struct super_block *sb)
 	struct ext4_sb_info *sbi = EXT4_SB(sb);
 
 	/* Initialize fast commit stuff */
-	atomic_set(&sbi->s_fc_subtid, 0);
+	sbi->s_fc_started = 0;
+	sbi->s_fc_ended = 0;
+	sbi->s_fc_done = 0;
 	INIT_LIST_HEAD(&sbi->s_fc_q[FC_Q_MAIN]);
 	INIT_LIST_HEAD(&sbi->s_fc_q[FC_Q_STAGING]);
 	INIT_LIST_HEAD(&sbi->s_fc_dentry_q[FC_Q_MAIN]);
@@ -13,6 +13,8 @@ struct gro_cells {
 };
 
 int gro_cells_receive(struct gro_cells *gcells, struct sk_buff *skb);
+void gro_cells_receive_list(struct gro_cells *gcells,
+			    struct sk_buff_head *skbs);
 int gro_cells_init(struct gro_cells *gcells, struct net_device *dev);
 void gro_cells_destroy(struct gro_cells *gcells);
 
@@ -5122,6 +5122,30 @@ void ieee80211_restart_hw(struct ieee80211_hw *hw);
 void ieee80211_rx_list(struct ieee80211_hw *hw, struct ieee80211_sta *sta,
 		       struct sk_buff *skb, struct list_head *list);
 
+/**
+ * ieee80211_rx_list_batch - receive a batch of frames into a list
+ *
+ * Like ieee80211_rx_list(), but takes all frames a driver collected in
+ * one NAPI poll at once. Consecutive frames from the same station and TID
+ * that need the full RX handler chain, e.g. because they are decrypted in
+ * software, are passed through it as one list, so the RX path lock and
+ * the per-station state are taken once per run instead of once per frame.
+ * Frames of a BA session still go through the reorder buffer and the
+ * handlers one at a time. Frames are delivered in the order they were
+ * received.
+ *
+ * The same context requirements as for ieee80211_rx_list() apply.
+ *
+ * @hw: the hardware the frames came in on
+ * @sta: the station the frames were received from, or %NULL
+ * @skbs: the received frames, emptied by this function
+ * @list: the destination list
+ */
+void ieee80211_rx_list_batch(struct ieee80211_hw *hw,
+			     struct ieee80211_sta *sta,
+			     struct sk_buff_head *skbs,
+			     struct list_head *list);
+
 /**
  * ieee80211_rx_napi - receive frame from NAPI context
  *
@@ -7393,6 +7417,51 @@ void ieee80211_unreserve_tid(struct ieee80211_sta *sta, u8 tid);
 struct sk_buff *ieee80211_tx_dequeue(struct ieee80211_hw *hw,
 				     struct ieee80211_txq *txq);
 
+/**
+ * ieee80211_tx_dequeue_bulk - dequeue a batch of packets from a software
+ *	tx queue
+ *
+ * @hw: pointer as obtained from ieee80211_alloc_hw()
+ * @txq: pointer obtained from station or virtual interface, or from
+ *	ieee80211_next_txq()
+ * @skbs: list the dequeued frames are appended to, in transmit order
+ * @budget: maximum number of frames to dequeue, typically the free space
+ *	in the driver's hardware ring
+ *
+ * Like ieee80211_tx_dequeue(), but hands the driver up to @budget frames
+ * at once. The frames are taken off the TXQ together under a single lock
+ * hold and then go through the TX handlers one by one. The batch ends
+ * early when the queue is stopped or runs out of airtime. Frames the
+ * driver cannot queue to the hardware after all must be given back with
+ * ieee80211_tx_requeue_bulk().
+ *
+ * The same RCU and softirq requirements as for ieee80211_tx_dequeue()
+ * apply; the RCU critical section must persist until all frames on @skbs
+ * were handled.
+ *
+ * Return: the number of frames appended to @skbs.
+ */
+int ieee80211_tx_dequeue_bulk(struct ieee80211_hw *hw,
+			      struct ieee80211_txq *txq,
+			      struct sk_buff_head *skbs, int budget);
+
+/**
+ * ieee80211_tx_requeue_bulk - give back frames from a bulk dequeue
+ *
+ * @hw: pointer as obtained from ieee80211_alloc_hw()
+ * @txq: the software tx queue the frames were dequeued from
+ * @skbs: frames from ieee80211_tx_dequeue_bulk() that the driver did not
+ *	queue to the hardware, in transmit order; emptied by this function
+ *
+ * Puts the frames back at the head of @txq. They were already processed
+ * and are returned unchanged, before any other frame of @txq, by the next
+ * dequeue. Must be called within the same RCU critical section as the
+ * dequeue and before ieee80211_return_txq().
+ */
+void ieee80211_tx_requeue_bulk(struct ieee80211_hw *hw,
+			       struct ieee80211_txq *txq,
+			       struct sk_buff_head *skbs);
+
 /**
  * ieee80211_tx_dequeue_ni - dequeue a packet from a software tx queue
  * (in process context)
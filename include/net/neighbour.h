@@ -131,9 +131,14 @@ struct neigh_statistics {
 
 	unsigned long unres_discards;	/* number of unresolved drops */
 	unsigned long table_fulls;      /* times even gc couldn't help */
+
+	unsigned long forced_gc_usecs;	/* time spent in forced GC */
+	unsigned long hash_grow_usecs;	/* time table locked for resizes */
 };
 
 #define NEIGH_CACHE_STAT_INC(tbl, field) this_cpu_inc((tbl)->stats->field)
+#define NEIGH_CACHE_STAT_ADD(tbl, field, val) \
+	this_cpu_add((tbl)->stats->field, (val))
 
 struct neighbour {
 	struct hlist_node	hash;
@@ -225,6 +230,8 @@ struct neigh_table {
 	unsigned long		last_flush;
 	struct delayed_work	gc_work;
 	struct delayed_work	managed_work;
+	struct work_struct	forced_gc_work;
+	struct work_struct	hash_grow_work;
 	struct timer_list 	proxy_timer;
 	struct sk_buff_head	proxy_queue;
 	atomic_t		entries;
@@ -372,6 +372,7 @@ struct xfrm_dst_lookup_params {
 struct net_device;
 struct xfrm_type;
 struct xfrm_dst;
+struct seq_file;
 struct xfrm_policy_afinfo {
 	struct dst_ops		*dst_ops;
 	struct dst_entry	*(*dst_lookup)(const struct xfrm_dst_lookup_params *params);
@@ -481,6 +482,7 @@ void xfrm_unregister_type_offload(const struct xfrm_type_offload *type, unsigned
  *	`transport_header` should point at ESP header, `network_header` should
  *	point at outer IP header and `mac_header` should opint at the
  *	protocol/nexthdr field of the outer IP.
+ * @proc_show: Append mode specific counters for `net` to /proc/net/xfrm_stat
  *
  * One should examine and understand the specific uses of these callbacks in
  * xfrm for further detail on how and when these functions are called. RTSL.
@@ -499,10 +501,12 @@ struct xfrm_mode_cbs {
 	int	(*input)(struct xfrm_state *x, struct sk_buff *skb);
 	int	(*output)(struct net *net, struct sock *sk, struct sk_buff *skb);
 	int	(*prepare_output)(struct xfrm_state *x, struct sk_buff *skb);
+	void	(*proc_show)(struct net *net, struct seq_file *seq);
 };
 
 int xfrm_register_mode_cbs(u8 mode, const struct xfrm_mode_cbs *mode_cbs);
 void xfrm_unregister_mode_cbs(u8 mode);
+void xfrm_mode_cbs_proc_show(struct net *net, struct seq_file *seq);
 
 static inline int xfrm_af2proto(unsigned int family)
 {
@@ -599,7 +603,8 @@ struct xfrm_policy_queue {
  *	@curlft: liftime state
  *	@walk: list head on pernet policy list
  *	@polq: queue to hold packets while aqcuire operaion in progress
- *	@bydst_reinsert: policy tree node needs to be merged
+ *	@bydst_reinsert: entry on the list of policies to move into a merged
+ *			 policy tree node
  *	@type: XFRM_POLICY_TYPE_MAIN or _SUB
  *	@action: XFRM_POLICY_ALLOW or _BLOCK
  *	@flags: XFRM_POLICY_LOCALOK, XFRM_POLICY_ICMP
@@ -633,7 +638,7 @@ struct xfrm_policy {
 	struct xfrm_lifetime_cur curlft;
 	struct xfrm_policy_walk_entry walk;
 	struct xfrm_policy_queue polq;
-	bool                    bydst_reinsert;
+	struct list_head	bydst_reinsert;
 	u8			type;
 	u8			action;
 	u8			flags;
@@ -1685,6 +1690,7 @@ struct xfrm_state *xfrm_stateonly_find(struct net *net, u32 mark, u32 if_id,
 struct xfrm_state *xfrm_state_lookup_byspi(struct net *net, __be32 spi,
 					      unsigned short family);
 int xfrm_state_check_expire(struct xfrm_state *x);
+bool xfrm_state_expire_nolock_ok(const struct xfrm_state *x);
 void xfrm_state_update_stats(struct net *net);
 #ifdef CONFIG_XFRM_OFFLOAD
 static inline void xfrm_dev_state_update_stats(struct xfrm_state *x)
@@ -1937,6 +1943,7 @@ int xfrm_replay_check(struct xfrm_state *x, struct sk_buff *skb, __be32 net_seq)
 void xfrm_replay_notify(struct xfrm_state *x, int event);
 int xfrm_replay_overflow(struct xfrm_state *x, struct sk_buff *skb);
 int xfrm_replay_recheck(struct xfrm_state *x, struct sk_buff *skb, __be32 net_seq);
+bool xfrm_replay_check_ahead(const struct xfrm_state *x, __be32 net_seq);
 
 static inline int xfrm_aevent_is_on(struct net *net)
 {
@@ -37,6 +37,9 @@
 
 #define VIRTQUEUE_NUM	128
 
+/* replies reaped from the ring per channel lock hold in req_done() */
+#define P9_VIRTIO_DONE_BATCH	16
+
 /* a single mutex to manage channel initialization and attachment */
 static DEFINE_MUTEX(virtio_9p_lock);
 static DECLARE_WAIT_QUEUE_HEAD(vp_wq);
@@ -128,26 +131,39 @@ static void p9_virtio_close(struct p9_client *client)
 static void req_done(struct virtqueue *vq)
 {
 	struct virtio_chan *chan = vq->vdev->priv;
-	unsigned int len;
+	struct p9_req_t *done[P9_VIRTIO_DONE_BATCH];
+	unsigned int len, i, n;
 	struct p9_req_t *req;
 	bool need_wakeup = false;
 	unsigned long flags;
 
 	p9_debug(P9_DEBUG_TRANS, ": request done\n");
 
-	spin_lock_irqsave(&chan->lock, flags);
-	while ((req = virtqueue_get_buf(chan->vq, &len)) != NULL) {
-		if (!chan->ring_bufs_avail) {
-			chan->ring_bufs_avail = 1;
-			need_wakeup = true;
-		}
+	/* Reap replies in batches and complete them without holding the
+	 * channel lock, so that submitters are not held off by the wakeups
+	 * and request puts done by p9_client_cb().
+	 */
+	do {
+		n = 0;
+		spin_lock_irqsave(&chan->lock, flags);
+		while (n < ARRAY_SIZE(done) &&
+		       (req = virtqueue_get_buf(chan->vq, &len)) != NULL) {
+			if (!chan->ring_bufs_avail) {
+				chan->ring_bufs_avail = 1;
+				need_wakeup = true;
+			}
 
-		if (len) {
-			req->rc.size = len;
-			p9_client_cb(chan->client, req, REQ_STATUS_RCVD);
+			if (len) {
+				req->rc.size = len;
+				done[n++] = req;
+			}
 		}
-	}
-	spin_unlock_irqrestore(&chan->lock, flags);
+		spin_unlock_irqrestore(&chan->lock, flags);
+
+		for (i = 0; i < n; i++)
+			p9_client_cb(chan->client, done[i], REQ_STATUS_RCVD);
+	} while (n == ARRAY_SIZE(done));
+
 	/* Wakeup if anyone waiting for VirtIO ring space. */
 	if (need_wakeup)
 		wake_up(chan->vc_wq);
@@ -259,6 +275,7 @@ p9_virtio_request(struct p9_client *client, struct p9_req_t *req)
 	unsigned long flags;
 	struct virtio_chan *chan = client->trans;
 	struct scatterlist *sgs[2];
+	bool notify;
 
 	p9_debug(P9_DEBUG_TRANS, "9p debug: virtio request\n");
 
@@ -298,8 +315,10 @@ p9_virtio_request(struct p9_client *client, struct p9_req_t *req)
 			return -EIO;
 		}
 	}
-	virtqueue_kick(chan->vq);
+	notify = virtqueue_kick_prepare(chan->vq);
 	spin_unlock_irqrestore(&chan->lock, flags);
+	if (notify)
+		virtqueue_notify(chan->vq);
 
 	p9_debug(P9_DEBUG_TRANS, "virtio request kicked\n");
 	return 0;
@@ -431,6 +450,7 @@ p9_virtio_zc_request(struct p9_client *client, struct p9_req_t *req,
 	size_t offs = 0;
 	int need_drop = 0;
 	int kicked = 0;
+	bool notify;
 
 	p9_debug(P9_DEBUG_TRANS, "virtio request\n");
 
@@ -527,8 +547,10 @@ p9_virtio_zc_request(struct p9_client *client, struct p9_req_t *req,
 			goto err_out;
 		}
 	}
-	virtqueue_kick(chan->vq);
+	notify = virtqueue_kick_prepare(chan->vq);
 	spin_unlock_irqrestore(&chan->lock, flags);
+	if (notify)
+		virtqueue_notify(chan->vq);
 	kicked = 1;
 	p9_debug(P9_DEBUG_TRANS, "virtio request kicked\n");
 	err = wait_event_killable(req->wq,
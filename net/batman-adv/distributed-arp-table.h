@@ -10,6 +10,8 @@
 #include "main.h"
 
 #include <linux/compiler.h>
+#include <linux/if_ether.h>
+#include <linux/jhash.h>
 #include <linux/netdevice.h>
 #include <linux/netlink.h>
 #include <linux/skbuff.h>
@@ -41,6 +43,20 @@ void batadv_dat_snoop_incoming_dhcp_ack(struct batadv_priv *bat_priv,
 bool batadv_dat_drop_broadcast_packet(struct batadv_priv *bat_priv,
 				      struct batadv_forw_packet *forw_packet);
 
+/**
+ * batadv_dat_choose_addr() - compute the DAT address of a node
+ * @addr: mac address of the node
+ *
+ * Every node computes the DAT addresses of the others itself, so this must
+ * give the same result on all nodes of the mesh, whatever their version.
+ *
+ * Return: the DAT address of the node owning @addr
+ */
+static inline u32 batadv_dat_choose_addr(const u8 *addr)
+{
+	return jhash(addr, ETH_ALEN, 0) % BATADV_DAT_ADDR_MAX;
+}
+
 /**
  * batadv_dat_init_orig_node_addr() - assign a DAT address to the orig_node
  * @orig_node: the node to assign the DAT address to
@@ -50,7 +66,7 @@ batadv_dat_init_orig_node_addr(struct batadv_orig_node *orig_node)
 {
 	u32 addr;
 
-	addr = batadv_choose_orig(orig_node->orig, BATADV_DAT_ADDR_MAX);
+	addr = batadv_dat_choose_addr(orig_node->orig);
 	orig_node->dat_addr = (batadv_dat_addr_t)addr;
 }
 
@@ -65,8 +81,7 @@ batadv_dat_init_own_addr(struct batadv_priv *bat_priv,
 {
 	u32 addr;
 
-	addr = batadv_choose_orig(primary_if->net_dev->dev_addr,
-				  BATADV_DAT_ADDR_MAX);
+	addr = batadv_dat_choose_addr(primary_if->net_dev->dev_addr);
 
 	bat_priv->dat.addr = (batadv_dat_addr_t)addr;
 }
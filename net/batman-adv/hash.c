@@ -9,6 +9,7 @@
 
 #include <linux/gfp.h>
 #include <linux/lockdep.h>
+#include <linux/log2.h>
 #include <linux/slab.h>
 
 /* clears the hash */
@@ -37,7 +38,7 @@ void batadv_hash_destroy(struct batadv_hashtable *hash)
 
 /**
  * batadv_hash_new() - Allocates and clears the hashtable
- * @size: number of hash buckets to allocate
+ * @size: number of hash buckets to allocate, rounded up to a power of two
  *
  * Return: newly allocated hashtable, NULL on errors
  */
@@ -45,6 +46,8 @@ struct batadv_hashtable *batadv_hash_new(u32 size)
 {
 	struct batadv_hashtable *hash;
 
+	size = roundup_pow_of_two(size);
+
 	hash = kmalloc(sizeof(*hash), GFP_ATOMIC);
 	if (!hash)
 		return NULL;
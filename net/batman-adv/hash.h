@@ -44,7 +44,10 @@ struct batadv_hashtable {
 	/** @list_locks: spinlock for each hash list entry */
 	spinlock_t *list_locks;
 
-	/** @size: size of hashtable */
+	/**
+	 * @size: size of hashtable, always a power of two so that the choose
+	 *  callbacks can mask instead of divide
+	 */
 	u32 size;
 
 	/** @generation: current (generation) sequence number */
@@ -58,6 +58,7 @@ batadv_orig_hash_find(struct batadv_priv *bat_priv, const void *data)
 	struct batadv_hashtable *hash = bat_priv->orig_hash;
 	struct hlist_head *head;
 	struct batadv_orig_node *orig_node, *orig_node_tmp = NULL;
+	unsigned int steps = 0;
 	int index;
 
 	if (!hash)
@@ -68,6 +69,7 @@ batadv_orig_hash_find(struct batadv_priv *bat_priv, const void *data)
 
 	rcu_read_lock();
 	hlist_for_each_entry_rcu(orig_node, head, hash_entry) {
+		steps++;
 		if (!batadv_compare_eth(orig_node, data))
 			continue;
 
@@ -79,6 +81,9 @@ batadv_orig_hash_find(struct batadv_priv *bat_priv, const void *data)
 	}
 	rcu_read_unlock();
 
+	batadv_inc_counter(bat_priv, BATADV_CNT_ORIG_LOOKUP);
+	batadv_add_counter(bat_priv, BATADV_CNT_ORIG_LOOKUP_STEPS, steps);
+
 	return orig_node_tmp;
 }
 
@@ -16,6 +16,7 @@
 #include <linux/netlink.h>
 #include <linux/skbuff.h>
 #include <linux/types.h>
+#include <linux/unaligned.h>
 
 bool batadv_compare_orig(const struct hlist_node *node, const void *data2);
 int batadv_originator_init(struct batadv_priv *bat_priv);
@@ -69,17 +70,22 @@ void batadv_orig_node_vlan_release(struct kref *ref);
 /**
  * batadv_choose_orig() - Return the index of the orig entry in the hash table
  * @data: mac address of the originator node
- * @size: the size of the hash table
+ * @size: the size of the hash table, a power of two
+ *
+ * Only for batadv_hashtable buckets, which are local to this node. DAT
+ * addresses are shared across the mesh and use batadv_dat_choose_addr().
  *
  * Return: the hash index where the object represented by @data should be
  * stored at.
  */
 static inline u32 batadv_choose_orig(const void *data, u32 size)
 {
-	u32 hash = 0;
+	const u8 *addr = data;
+	u32 hash;
 
-	hash = jhash(data, ETH_ALEN, hash);
-	return hash % size;
+	hash = jhash_2words(get_unaligned((const u32 *)addr),
+			    get_unaligned((const u16 *)(addr + 4)), 0);
+	return hash & (size - 1);
 }
 
 struct batadv_orig_node *
@@ -943,6 +943,10 @@ static const struct {
 	{ "tt_response_rx" },
 	{ "tt_roam_adv_tx" },
 	{ "tt_roam_adv_rx" },
+	{ "tt_lookup" },
+	{ "tt_lookup_steps" },
+	{ "orig_lookup" },
+	{ "orig_lookup_steps" },
 #ifdef CONFIG_BATMAN_ADV_MCAST
 	{ "mcast_tx" },
 	{ "mcast_tx_bytes" },
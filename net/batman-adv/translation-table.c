@@ -37,6 +37,7 @@
 #include <linux/spinlock.h>
 #include <linux/stddef.h>
 #include <linux/string.h>
+#include <linux/unaligned.h>
 #include <linux/workqueue.h>
 #include <net/genetlink.h>
 #include <net/netlink.h>
@@ -105,30 +106,39 @@ static bool batadv_compare_tt(const struct hlist_node *node, const void *data2)
 static inline u32 batadv_choose_tt(const void *data, u32 size)
 {
 	const struct batadv_tt_common_entry *tt;
-	u32 hash = 0;
+	u32 hash;
 
 	tt = data;
-	hash = jhash(&tt->addr, ETH_ALEN, hash);
-	hash = jhash(&tt->vid, sizeof(tt->vid), hash);
+	hash = jhash_2words(get_unaligned((const u32 *)tt->addr),
+			    get_unaligned((const u16 *)(tt->addr + 4)) |
+			    (u32)tt->vid << 16, 0);
 
-	return hash % size;
+	return hash & (size - 1);
 }
 
 /**
- * batadv_tt_hash_find() - look for a client in the given hash table
+ * batadv_tt_hash_find_rcu() - look for a client in the given hash table
+ *  without taking a reference
+ * @bat_priv: the bat priv with all the soft interface information
  * @hash: the hash table to search
  * @addr: the mac address of the client to look for
  * @vid: VLAN identifier
  *
+ * The caller must hold rcu_read_lock() for as long as the returned entry is
+ * used. Entries are added at the head of their bucket, so the newest entry
+ * for a client shadows one that is still on its way out.
+ *
  * Return: a pointer to the tt_common struct belonging to the searched client if
  * found, NULL otherwise.
  */
 static struct batadv_tt_common_entry *
-batadv_tt_hash_find(struct batadv_hashtable *hash, const u8 *addr,
-		    unsigned short vid)
+batadv_tt_hash_find_rcu(struct batadv_priv *bat_priv,
+			struct batadv_hashtable *hash, const u8 *addr,
+			unsigned short vid)
 {
-	struct hlist_head *head;
 	struct batadv_tt_common_entry to_search, *tt, *tt_tmp = NULL;
+	struct hlist_head *head;
+	unsigned int steps = 0;
 	u32 index;
 
 	if (!hash)
@@ -140,25 +150,49 @@ batadv_tt_hash_find(struct batadv_hashtable *hash, const u8 *addr,
 	index = batadv_choose_tt(&to_search, hash->size);
 	head = &hash->table[index];
 
-	rcu_read_lock();
 	hlist_for_each_entry_rcu(tt, head, hash_entry) {
+		steps++;
 		if (!batadv_compare_eth(tt, addr))
 			continue;
 
 		if (tt->vid != vid)
 			continue;
 
-		if (!kref_get_unless_zero(&tt->refcount))
-			continue;
-
 		tt_tmp = tt;
 		break;
 	}
-	rcu_read_unlock();
+
+	batadv_inc_counter(bat_priv, BATADV_CNT_TT_LOOKUP);
+	batadv_add_counter(bat_priv, BATADV_CNT_TT_LOOKUP_STEPS, steps);
 
 	return tt_tmp;
 }
 
+/**
+ * batadv_tt_hash_find() - look for a client in the given hash table
+ * @bat_priv: the bat priv with all the soft interface information
+ * @hash: the hash table to search
+ * @addr: the mac address of the client to look for
+ * @vid: VLAN identifier
+ *
+ * Return: a pointer to the tt_common struct belonging to the searched client if
+ * found, NULL otherwise. The reference has to be dropped by the caller.
+ */
+static struct batadv_tt_common_entry *
+batadv_tt_hash_find(struct batadv_priv *bat_priv, struct batadv_hashtable *hash,
+		    const u8 *addr, unsigned short vid)
+{
+	struct batadv_tt_common_entry *tt;
+
+	rcu_read_lock();
+	tt = batadv_tt_hash_find_rcu(bat_priv, hash, addr, vid);
+	if (tt && !kref_get_unless_zero(&tt->refcount))
+		tt = NULL;
+	rcu_read_unlock();
+
+	return tt;
+}
+
 /**
  * batadv_tt_local_hash_find() - search the local table for a given client
  * @bat_priv: the bat priv with all the soft interface information
@@ -175,8 +209,8 @@ batadv_tt_local_hash_find(struct batadv_priv *bat_priv, const u8 *addr,
 	struct batadv_tt_common_entry *tt_common_entry;
 	struct batadv_tt_local_entry *tt_local_entry = NULL;
 
-	tt_common_entry = batadv_tt_hash_find(bat_priv->tt.local_hash, addr,
-					      vid);
+	tt_common_entry = batadv_tt_hash_find(bat_priv, bat_priv->tt.local_hash,
+					      addr, vid);
 	if (tt_common_entry)
 		tt_local_entry = container_of(tt_common_entry,
 					      struct batadv_tt_local_entry,
@@ -200,8 +234,8 @@ batadv_tt_global_hash_find(struct batadv_priv *bat_priv, const u8 *addr,
 	struct batadv_tt_common_entry *tt_common_entry;
 	struct batadv_tt_global_entry *tt_global_entry = NULL;
 
-	tt_common_entry = batadv_tt_hash_find(bat_priv->tt.global_hash, addr,
-					      vid);
+	tt_common_entry = batadv_tt_hash_find(bat_priv, bat_priv->tt.global_hash,
+					      addr, vid);
 	if (tt_common_entry)
 		tt_global_entry = container_of(tt_common_entry,
 					       struct batadv_tt_global_entry,
@@ -3289,21 +3323,23 @@ static void batadv_tt_update_changes(struct batadv_priv *bat_priv,
 bool batadv_is_my_client(struct batadv_priv *bat_priv, const u8 *addr,
 			 unsigned short vid)
 {
-	struct batadv_tt_local_entry *tt_local_entry;
+	struct batadv_tt_common_entry *tt_common;
 	bool ret = false;
 
-	tt_local_entry = batadv_tt_local_hash_find(bat_priv, addr, vid);
-	if (!tt_local_entry)
+	rcu_read_lock();
+	tt_common = batadv_tt_hash_find_rcu(bat_priv, bat_priv->tt.local_hash,
+					    addr, vid);
+	if (!tt_common)
 		goto out;
 	/* Check if the client has been logically deleted (but is kept for
 	 * consistency purpose)
 	 */
-	if ((tt_local_entry->common.flags & BATADV_TT_CLIENT_PENDING) ||
-	    (tt_local_entry->common.flags & BATADV_TT_CLIENT_ROAM))
+	if ((tt_common->flags & BATADV_TT_CLIENT_PENDING) ||
+	    (tt_common->flags & BATADV_TT_CLIENT_ROAM))
 		goto out;
 	ret = true;
 out:
-	batadv_tt_local_entry_put(tt_local_entry);
+	rcu_read_unlock();
 	return ret;
 }
 
@@ -3809,16 +3845,16 @@ static void batadv_tt_update_orig(struct batadv_priv *bat_priv,
 bool batadv_tt_global_client_is_roaming(struct batadv_priv *bat_priv,
 					u8 *addr, unsigned short vid)
 {
-	struct batadv_tt_global_entry *tt_global_entry;
+	struct batadv_tt_common_entry *tt_common;
 	bool ret = false;
 
-	tt_global_entry = batadv_tt_global_hash_find(bat_priv, addr, vid);
-	if (!tt_global_entry)
-		goto out;
+	rcu_read_lock();
+	tt_common = batadv_tt_hash_find_rcu(bat_priv, bat_priv->tt.global_hash,
+					    addr, vid);
+	if (tt_common)
+		ret = tt_common->flags & BATADV_TT_CLIENT_ROAM;
+	rcu_read_unlock();
 
-	ret = tt_global_entry->common.flags & BATADV_TT_CLIENT_ROAM;
-	batadv_tt_global_entry_put(tt_global_entry);
-out:
 	return ret;
 }
 
@@ -3835,16 +3871,16 @@ bool batadv_tt_global_client_is_roaming(struct batadv_priv *bat_priv,
 bool batadv_tt_local_client_is_roaming(struct batadv_priv *bat_priv,
 				       u8 *addr, unsigned short vid)
 {
-	struct batadv_tt_local_entry *tt_local_entry;
+	struct batadv_tt_common_entry *tt_common;
 	bool ret = false;
 
-	tt_local_entry = batadv_tt_local_hash_find(bat_priv, addr, vid);
-	if (!tt_local_entry)
-		goto out;
+	rcu_read_lock();
+	tt_common = batadv_tt_hash_find_rcu(bat_priv, bat_priv->tt.local_hash,
+					    addr, vid);
+	if (tt_common)
+		ret = tt_common->flags & BATADV_TT_CLIENT_ROAM;
+	rcu_read_unlock();
 
-	ret = tt_local_entry->common.flags & BATADV_TT_CLIENT_ROAM;
-	batadv_tt_local_entry_put(tt_local_entry);
-out:
 	return ret;
 }
 
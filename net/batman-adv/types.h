@@ -862,6 +862,24 @@ enum batadv_counters {
 	 */
 	BATADV_CNT_TT_ROAM_ADV_RX,
 
+	/** @BATADV_CNT_TT_LOOKUP: translation table lookup counter */
+	BATADV_CNT_TT_LOOKUP,
+
+	/**
+	 * @BATADV_CNT_TT_LOOKUP_STEPS: translation table entries walked by
+	 *  lookups, divided by @BATADV_CNT_TT_LOOKUP gives the mean chain length
+	 */
+	BATADV_CNT_TT_LOOKUP_STEPS,
+
+	/** @BATADV_CNT_ORIG_LOOKUP: originator table lookup counter */
+	BATADV_CNT_ORIG_LOOKUP,
+
+	/**
+	 * @BATADV_CNT_ORIG_LOOKUP_STEPS: originator table entries walked by
+	 *  lookups
+	 */
+	BATADV_CNT_ORIG_LOOKUP_STEPS,
+
 #ifdef CONFIG_BATMAN_ADV_MCAST
 	/**
 	 * @BATADV_CNT_MCAST_TX: transmitted batman-adv multicast packets
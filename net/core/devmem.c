@@ -67,29 +67,52 @@ void __net_devmem_dmabuf_binding_free(struct net_devmem_dmabuf_binding *binding)
 	kfree(binding);
 }
 
+/* Carve up to *@count net_iovs out of a single contiguous range of the
+ * binding's chunk pool, so that refilling a page pool costs one walk of the
+ * genpool bitmap rather than one per buffer. Returns the first net_iov of
+ * the range, the others follow it in the chunk's niovs array, and sets
+ * *@count to the size of the range. If no run of *@count pages is free,
+ * only a single page is tried next, so a fragmented pool is not searched
+ * again for every smaller size.
+ */
 struct net_iov *
-net_devmem_alloc_dmabuf(struct net_devmem_dmabuf_binding *binding)
+net_devmem_alloc_dmabuf_bulk(struct net_devmem_dmabuf_binding *binding,
+			     unsigned int *count)
 {
 	struct dmabuf_genpool_chunk_owner *owner;
 	unsigned long dma_addr;
 	struct net_iov *niov;
-	ssize_t offset;
 	ssize_t index;
+	unsigned int i;
 
-	dma_addr = gen_pool_alloc_owner(binding->chunk_pool, PAGE_SIZE,
-					(void **)&owner);
+	dma_addr = gen_pool_alloc_owner(binding->chunk_pool,
+					*count * PAGE_SIZE, (void **)&owner);
+	if (!dma_addr && *count > 1) {
+		*count = 1;
+		dma_addr = gen_pool_alloc_owner(binding->chunk_pool, PAGE_SIZE,
+						(void **)&owner);
+	}
 	if (!dma_addr)
 		return NULL;
 
-	offset = dma_addr - owner->base_dma_addr;
-	index = offset / PAGE_SIZE;
-	niov = &owner->niovs[index];
+	index = (dma_addr - owner->base_dma_addr) / PAGE_SIZE;
+	for (i = 0; i < *count; i++) {
+		niov = &owner->niovs[index + i];
 
-	niov->pp_magic = 0;
-	niov->pp = NULL;
-	atomic_long_set(&niov->pp_ref_count, 0);
+		niov->pp_magic = 0;
+		niov->pp = NULL;
+		atomic_long_set(&niov->pp_ref_count, 0);
+	}
 
-	return niov;
+	return &owner->niovs[index];
+}
+
+struct net_iov *
+net_devmem_alloc_dmabuf(struct net_devmem_dmabuf_binding *binding)
+{
+	unsigned int count = 1;
+
+	return net_devmem_alloc_dmabuf_bulk(binding, &count);
 }
 
 void net_devmem_free_dmabuf(struct net_iov *niov)
@@ -358,20 +381,34 @@ int mp_dmabuf_devmem_init(struct page_pool *pool)
 netmem_ref mp_dmabuf_devmem_alloc_netmems(struct page_pool *pool, gfp_t gfp)
 {
 	struct net_devmem_dmabuf_binding *binding = pool->mp_priv;
+	unsigned int i, nr = PP_ALLOC_CACHE_REFILL;
 	struct net_iov *niov;
 	netmem_ref netmem;
 
-	niov = net_devmem_alloc_dmabuf(binding);
+	/* Unnecessary as alloc cache is empty, but guarantees zero count */
+	if (unlikely(pool->alloc.count > 0))
+		return pool->alloc.cache[--pool->alloc.count];
+
+	niov = net_devmem_alloc_dmabuf_bulk(binding, &nr);
 	if (!niov)
 		return 0;
 
-	netmem = net_iov_to_netmem(niov);
+	/* Fill the alloc cache straight away, like the alloc_pages_bulk()
+	 * slow path of the page pool does
+	 */
+	for (i = 0; i < nr; i++) {
+		netmem = net_iov_to_netmem(niov + i);
+
+		page_pool_set_pp_info(pool, netmem);
+		pool->alloc.cache[pool->alloc.count++] = netmem;
 
-	page_pool_set_pp_info(pool, netmem);
+		pool->pages_state_hold_cnt++;
+		trace_page_pool_state_hold(pool, netmem,
+					   pool->pages_state_hold_cnt);
+	}
 
-	pool->pages_state_hold_cnt++;
-	trace_page_pool_state_hold(pool, netmem, pool->pages_state_hold_cnt);
-	return netmem;
+	/* Return the last one, the rest stay in the alloc cache */
+	return pool->alloc.cache[--pool->alloc.count];
 }
 
 void mp_dmabuf_devmem_destroy(struct page_pool *pool)
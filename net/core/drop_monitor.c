@@ -27,6 +27,8 @@
 #include <linux/bitops.h>
 #include <linux/slab.h>
 #include <linux/module.h>
+#include <linux/jhash.h>
+#include <linux/log2.h>
 #include <net/genetlink.h>
 #include <net/netevent.h>
 #include <net/flow_offload.h>
@@ -73,14 +75,37 @@ struct net_dm_hw_entries {
 	struct net_dm_hw_entry entries[];
 };
 
+/* Drops are aggregated per CPU by drop reason, location, input device and,
+ * optionally, flow hash.
+ */
+struct net_dm_aggr_key {
+	void *pc;
+	enum skb_drop_reason reason;
+	int ifindex;
+	u32 flow_hash;
+};
+
+struct net_dm_aggr_entry {
+	struct net_dm_aggr_key key;
+	u64 count;	/* 0 for a free slot */
+};
+
+/* Open addressed, twice the size of dm_hit_limit so probing always ends */
+struct net_dm_aggr_entries {
+	u32 num_entries;
+	u32 mask;
+	struct net_dm_aggr_entry entries[];
+};
+
 struct per_cpu_dm_data {
-	raw_spinlock_t		lock;	/* Protects 'skb', 'hw_entries' and
-					 * 'send_timer'
+	raw_spinlock_t		lock;	/* Protects 'skb', 'hw_entries',
+					 * 'aggr_entries' and 'send_timer'
 					 */
 	union {
 		struct sk_buff			*skb;
 		struct net_dm_hw_entries	*hw_entries;
 	};
+	struct net_dm_aggr_entries	*aggr_entries;
 	struct sk_buff_head	drop_queue;
 	struct work_struct	dm_alert_work;
 	struct timer_list	send_timer;
@@ -105,6 +130,7 @@ static unsigned long dm_hw_check_delta = 2*HZ;
 static enum net_dm_alert_mode net_dm_alert_mode = NET_DM_ALERT_MODE_SUMMARY;
 static u32 net_dm_trunc_len;
 static u32 net_dm_queue_len = 1000;
+static bool net_dm_aggr_flow;
 
 struct net_dm_alert_ops {
 	void (*kfree_skb_probe)(void *ignore, struct sk_buff *skb,
@@ -609,12 +635,36 @@ static int net_dm_packet_report_in_port_put(struct sk_buff *msg, int ifindex,
 	return -EMSGSIZE;
 }
 
+static int net_dm_reason_put(struct sk_buff *msg,
+			     enum skb_drop_reason reason)
+{
+	const struct drop_reason_list *list = NULL;
+	unsigned int subsys, subsys_reason;
+	int rc;
+
+	rcu_read_lock();
+	subsys = u32_get_bits(reason, SKB_DROP_REASON_SUBSYS_MASK);
+	if (subsys < SKB_DROP_REASON_SUBSYS_NUM)
+		list = rcu_dereference(drop_reasons_by_subsys[subsys]);
+	subsys_reason = reason & ~SKB_DROP_REASON_SUBSYS_MASK;
+	if (!list ||
+	    subsys_reason >= list->n_reasons ||
+	    !list->reasons[subsys_reason] ||
+	    strlen(list->reasons[subsys_reason]) > NET_DM_MAX_REASON_LEN) {
+		list = rcu_dereference(drop_reasons_by_subsys[SKB_DROP_REASON_SUBSYS_CORE]);
+		subsys_reason = SKB_DROP_REASON_NOT_SPECIFIED;
+	}
+	rc = nla_put_string(msg, NET_DM_ATTR_REASON,
+			    list->reasons[subsys_reason]);
+	rcu_read_unlock();
+
+	return rc;
+}
+
 static int net_dm_packet_report_fill(struct sk_buff *msg, struct sk_buff *skb,
 				     size_t payload_len)
 {
 	struct net_dm_skb_cb *cb = NET_DM_SKB_CB(skb);
-	const struct drop_reason_list *list = NULL;
-	unsigned int subsys, subsys_reason;
 	char buf[NET_DM_MAX_SYMBOL_LEN];
 	struct nlattr *attr;
 	void *hdr;
@@ -632,24 +682,8 @@ static int net_dm_packet_report_fill(struct sk_buff *msg, struct sk_buff *skb,
 			      NET_DM_ATTR_PAD))
 		goto nla_put_failure;
 
-	rcu_read_lock();
-	subsys = u32_get_bits(cb->reason, SKB_DROP_REASON_SUBSYS_MASK);
-	if (subsys < SKB_DROP_REASON_SUBSYS_NUM)
-		list = rcu_dereference(drop_reasons_by_subsys[subsys]);
-	subsys_reason = cb->reason & ~SKB_DROP_REASON_SUBSYS_MASK;
-	if (!list ||
-	    subsys_reason >= list->n_reasons ||
-	    !list->reasons[subsys_reason] ||
-	    strlen(list->reasons[subsys_reason]) > NET_DM_MAX_REASON_LEN) {
-		list = rcu_dereference(drop_reasons_by_subsys[SKB_DROP_REASON_SUBSYS_CORE]);
-		subsys_reason = SKB_DROP_REASON_NOT_SPECIFIED;
-	}
-	if (nla_put_string(msg, NET_DM_ATTR_REASON,
-			   list->reasons[subsys_reason])) {
-		rcu_read_unlock();
+	if (net_dm_reason_put(msg, cb->reason))
 		goto nla_put_failure;
-	}
-	rcu_read_unlock();
 
 	snprintf(buf, sizeof(buf), "%pS", cb->pc);
 	if (nla_put_string(msg, NET_DM_ATTR_SYMBOL, buf))
@@ -1019,9 +1053,247 @@ static const struct net_dm_alert_ops net_dm_alert_packet_ops = {
 	.hw_trap_probe		= net_dm_hw_trap_packet_probe,
 };
 
+static struct net_dm_aggr_entries *
+net_dm_aggr_reset_per_cpu_data(struct per_cpu_dm_data *data)
+{
+	struct net_dm_aggr_entries *aggr_entries;
+	unsigned int size = roundup_pow_of_two(dm_hit_limit * 2);
+	unsigned long flags;
+
+	aggr_entries = kzalloc(struct_size(aggr_entries, entries, size),
+			       GFP_KERNEL);
+	if (aggr_entries)
+		aggr_entries->mask = size - 1;
+	else
+		mod_timer(&data->send_timer, jiffies + HZ / 10);
+
+	raw_spin_lock_irqsave(&data->lock, flags);
+	swap(data->aggr_entries, aggr_entries);
+	raw_spin_unlock_irqrestore(&data->lock, flags);
+
+	return aggr_entries;
+}
+
+static size_t net_dm_aggr_entry_size(void)
+{
+	       /* NET_DM_ATTR_DROP_ENTRY nest */
+	return nla_total_size(0) +
+	       /* NET_DM_ATTR_PC */
+	       nla_total_size(sizeof(u64)) +
+	       /* NET_DM_ATTR_SYMBOL */
+	       nla_total_size(NET_DM_MAX_SYMBOL_LEN + 1) +
+	       /* NET_DM_ATTR_REASON */
+	       nla_total_size(NET_DM_MAX_REASON_LEN + 1) +
+	       /* NET_DM_ATTR_IN_PORT */
+	       net_dm_in_port_size() +
+	       /* NET_DM_ATTR_FLOW_HASH */
+	       nla_total_size(sizeof(u32)) +
+	       /* NET_DM_ATTR_DROP_COUNT */
+	       nla_total_size(sizeof(u64));
+}
+
+static size_t net_dm_aggr_report_size(u32 num_entries)
+{
+	size_t size;
+
+	size = nlmsg_msg_size(GENL_HDRLEN + net_drop_monitor_family.hdrsize);
+
+	return NLMSG_ALIGN(size) +
+	       /* Ancillary header */
+	       nla_total_size(sizeof(struct net_dm_alert_msg)) +
+	       /* NET_DM_ATTR_DROP_ENTRIES */
+	       nla_total_size(0) +
+	       num_entries * net_dm_aggr_entry_size();
+}
+
+static int net_dm_aggr_entry_put(struct sk_buff *msg,
+				 const struct net_dm_aggr_entry *entry)
+{
+	char buf[NET_DM_MAX_SYMBOL_LEN];
+	struct nlattr *attr;
+
+	attr = nla_nest_start(msg, NET_DM_ATTR_DROP_ENTRY);
+	if (!attr)
+		return -EMSGSIZE;
+
+	if (nla_put_u64_64bit(msg, NET_DM_ATTR_PC,
+			      (u64)(uintptr_t)entry->key.pc, NET_DM_ATTR_PAD))
+		goto nla_put_failure;
+
+	snprintf(buf, sizeof(buf), "%pS", entry->key.pc);
+	if (nla_put_string(msg, NET_DM_ATTR_SYMBOL, buf))
+		goto nla_put_failure;
+
+	if (net_dm_reason_put(msg, entry->key.reason))
+		goto nla_put_failure;
+
+	if (net_dm_packet_report_in_port_put(msg, entry->key.ifindex, NULL))
+		goto nla_put_failure;
+
+	if (net_dm_aggr_flow &&
+	    nla_put_u32(msg, NET_DM_ATTR_FLOW_HASH, entry->key.flow_hash))
+		goto nla_put_failure;
+
+	if (nla_put_u64_64bit(msg, NET_DM_ATTR_DROP_COUNT, entry->count,
+			      NET_DM_ATTR_PAD))
+		goto nla_put_failure;
+
+	nla_nest_end(msg, attr);
+
+	return 0;
+
+nla_put_failure:
+	nla_nest_cancel(msg, attr);
+	return -EMSGSIZE;
+}
+
+static int
+net_dm_aggr_report_fill(struct sk_buff *msg,
+			const struct net_dm_aggr_entries *aggr_entries)
+{
+	struct net_dm_alert_msg anc_hdr = { 0 };
+	struct nlattr *attr;
+	void *hdr;
+	u32 i;
+
+	hdr = genlmsg_put(msg, 0, 0, &net_drop_monitor_family, 0,
+			  NET_DM_CMD_ALERT);
+	if (!hdr)
+		return -EMSGSIZE;
+
+	/* We need to put the ancillary header in order not to break user
+	 * space.
+	 */
+	if (nla_put(msg, NLA_UNSPEC, sizeof(anc_hdr), &anc_hdr))
+		goto nla_put_failure;
+
+	attr = nla_nest_start(msg, NET_DM_ATTR_DROP_ENTRIES);
+	if (!attr)
+		goto nla_put_failure;
+
+	for (i = 0; i <= aggr_entries->mask; i++) {
+		const struct net_dm_aggr_entry *entry;
+
+		entry = &aggr_entries->entries[i];
+		if (!entry->count)
+			continue;
+		if (net_dm_aggr_entry_put(msg, entry))
+			goto nla_put_failure;
+	}
+
+	nla_nest_end(msg, attr);
+	genlmsg_end(msg, hdr);
+
+	return 0;
+
+nla_put_failure:
+	genlmsg_cancel(msg, hdr);
+	return -EMSGSIZE;
+}
+
+static void net_dm_aggr_work(struct work_struct *work)
+{
+	struct net_dm_aggr_entries *aggr_entries;
+	struct per_cpu_dm_data *data;
+	struct sk_buff *msg;
+	int rc;
+
+	data = container_of(work, struct per_cpu_dm_data, dm_alert_work);
+
+	aggr_entries = net_dm_aggr_reset_per_cpu_data(data);
+	if (!aggr_entries || !aggr_entries->num_entries)
+		goto out;
+
+	msg = nlmsg_new(net_dm_aggr_report_size(aggr_entries->num_entries),
+			GFP_KERNEL);
+	if (!msg)
+		goto out;
+
+	rc = net_dm_aggr_report_fill(msg, aggr_entries);
+	if (rc) {
+		nlmsg_free(msg);
+		goto out;
+	}
+
+	genlmsg_multicast(&net_drop_monitor_family, msg, 0, 0, GFP_KERNEL);
+
+out:
+	kfree(aggr_entries);
+}
+
+/* Only a counter is bumped per drop, the summary of every CPU is sent at
+ * most once per dm_delay. Drops that do not fit the table anymore are
+ * accounted as not reported.
+ */
+static void net_dm_aggr_trace_kfree_skb_hit(void *ignore,
+					    struct sk_buff *skb,
+					    void *location,
+					    enum skb_drop_reason reason,
+					    struct sock *rx_sk)
+{
+	struct net_dm_aggr_entries *aggr_entries;
+	struct net_dm_aggr_entry *entry = NULL;
+	struct net_dm_aggr_key key = {};
+	struct per_cpu_dm_data *data;
+	unsigned long flags;
+	u32 hash, i;
+
+	key.pc = location;
+	key.reason = reason;
+	key.ifindex = skb->skb_iif;
+	if (net_dm_aggr_flow)
+		key.flow_hash = skb_get_hash(skb);
+	hash = jhash(&key, sizeof(key), 0);
+
+	local_irq_save(flags);
+	data = this_cpu_ptr(&dm_cpu_data);
+	raw_spin_lock(&data->lock);
+	aggr_entries = data->aggr_entries;
+
+	if (!aggr_entries)
+		goto out;
+
+	for (i = 0; i <= aggr_entries->mask; i++) {
+		entry = &aggr_entries->entries[(hash + i) & aggr_entries->mask];
+		if (!entry->count)
+			break;
+		if (!memcmp(&entry->key, &key, sizeof(key))) {
+			entry->count++;
+			goto out;
+		}
+	}
+	if (aggr_entries->num_entries >= dm_hit_limit) {
+		u64_stats_update_begin(&data->stats.syncp);
+		u64_stats_inc(&data->stats.dropped);
+		u64_stats_update_end(&data->stats.syncp);
+		goto out;
+	}
+
+	entry->key = key;
+	entry->count = 1;
+	aggr_entries->num_entries++;
+
+	if (!timer_pending(&data->send_timer)) {
+		data->send_timer.expires = jiffies + dm_delay * HZ;
+		add_timer(&data->send_timer);
+	}
+
+out:
+	raw_spin_unlock_irqrestore(&data->lock, flags);
+}
+
+static const struct net_dm_alert_ops net_dm_alert_aggr_ops = {
+	.kfree_skb_probe	= net_dm_aggr_trace_kfree_skb_hit,
+	.napi_poll_probe	= net_dm_packet_trace_napi_poll_hit,
+	.work_item_func		= net_dm_aggr_work,
+	.hw_work_item_func	= net_dm_hw_summary_work,
+	.hw_trap_probe		= net_dm_hw_trap_summary_probe,
+};
+
 static const struct net_dm_alert_ops *net_dm_alert_ops_arr[] = {
 	[NET_DM_ALERT_MODE_SUMMARY]	= &net_dm_alert_summary_ops,
 	[NET_DM_ALERT_MODE_PACKET]	= &net_dm_alert_packet_ops,
+	[NET_DM_ALERT_MODE_AGGREGATE]	= &net_dm_alert_aggr_ops,
 };
 
 #if IS_ENABLED(CONFIG_NET_DEVLINK)
@@ -1160,6 +1432,8 @@ static int net_dm_trace_on_set(struct netlink_ext_ack *extack)
 		 */
 		skb = reset_per_cpu_data(data);
 		consume_skb(skb);
+		if (net_dm_alert_mode == NET_DM_ALERT_MODE_AGGREGATE)
+			kfree(net_dm_aggr_reset_per_cpu_data(data));
 	}
 
 	rc = register_trace_kfree_skb(ops->kfree_skb_probe, NULL);
@@ -1187,6 +1461,8 @@ static int net_dm_trace_on_set(struct netlink_ext_ack *extack)
 		cancel_work_sync(&data->dm_alert_work);
 		while ((skb = __skb_dequeue(&data->drop_queue)))
 			consume_skb(skb);
+		kfree(data->aggr_entries);
+		data->aggr_entries = NULL;
 	}
 	module_put(THIS_MODULE);
 	return rc;
@@ -1215,6 +1491,8 @@ static void net_dm_trace_off_set(void)
 		cancel_work_sync(&data->dm_alert_work);
 		while ((skb = __skb_dequeue(&data->drop_queue)))
 			consume_skb(skb);
+		kfree(data->aggr_entries);
+		data->aggr_entries = NULL;
 	}
 
 	module_put(THIS_MODULE);
@@ -1264,6 +1542,7 @@ static int net_dm_alert_mode_get_from_info(struct genl_info *info,
 	switch (val) {
 	case NET_DM_ALERT_MODE_SUMMARY:
 	case NET_DM_ALERT_MODE_PACKET:
+	case NET_DM_ALERT_MODE_AGGREGATE:
 		*p_alert_mode = val;
 		break;
 	default:
@@ -1309,6 +1588,17 @@ static void net_dm_queue_len_set(struct genl_info *info)
 	net_dm_queue_len = nla_get_u32(info->attrs[NET_DM_ATTR_QUEUE_LEN]);
 }
 
+/* A flag cannot be cleared on its own, so it is taken along with the
+ * alert mode.
+ */
+static void net_dm_aggr_flow_set(struct genl_info *info)
+{
+	if (!info->attrs[NET_DM_ATTR_ALERT_MODE])
+		return;
+
+	net_dm_aggr_flow = nla_get_flag(info->attrs[NET_DM_ATTR_AGGR_FLOW]);
+}
+
 static int net_dm_cmd_config(struct sk_buff *skb,
 			struct genl_info *info)
 {
@@ -1328,6 +1618,8 @@ static int net_dm_cmd_config(struct sk_buff *skb,
 
 	net_dm_queue_len_set(info);
 
+	net_dm_aggr_flow_set(info);
+
 	return 0;
 }
 
@@ -1409,6 +1701,9 @@ static int net_dm_config_fill(struct sk_buff *msg, struct genl_info *info)
 	if (nla_put_u32(msg, NET_DM_ATTR_QUEUE_LEN, net_dm_queue_len))
 		goto nla_put_failure;
 
+	if (net_dm_aggr_flow && nla_put_flag(msg, NET_DM_ATTR_AGGR_FLOW))
+		goto nla_put_failure;
+
 	genlmsg_end(msg, hdr);
 
 	return 0;
@@ -1609,6 +1904,7 @@ static const struct nla_policy net_dm_nl_policy[NET_DM_ATTR_MAX + 1] = {
 	[NET_DM_ATTR_QUEUE_LEN] = { .type = NLA_U32 },
 	[NET_DM_ATTR_SW_DROPS]	= {. type = NLA_FLAG },
 	[NET_DM_ATTR_HW_DROPS]	= {. type = NLA_FLAG },
+	[NET_DM_ATTR_AGGR_FLOW]	= { .type = NLA_FLAG },
 };
 
 static const struct genl_small_ops dropmon_ops[] = {
@@ -1703,6 +1999,7 @@ static void net_dm_cpu_data_fini(int cpu)
 	 * to this struct and can free the skb inside it.
 	 */
 	consume_skb(data->skb);
+	kfree(data->aggr_entries);
 	__net_dm_cpu_data_fini(data);
 }
 
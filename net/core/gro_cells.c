@@ -47,6 +47,64 @@ int gro_cells_receive(struct gro_cells *gcells, struct sk_buff *skb)
 }
 EXPORT_SYMBOL(gro_cells_receive);
 
+/* Same as gro_cells_receive() for a list of skbs that were all received
+ * on the same device. The device checks and the NAPI schedule are done
+ * once for the whole list. @skbs is empty on return.
+ */
+void gro_cells_receive_list(struct gro_cells *gcells,
+			    struct sk_buff_head *skbs)
+{
+	struct sk_buff *skb = skb_peek(skbs);
+	struct net_device *dev;
+	struct gro_cell *cell;
+	bool was_empty;
+
+	if (!skb)
+		return;
+	dev = skb->dev;
+
+	rcu_read_lock();
+	if (unlikely(!(dev->flags & IFF_UP))) {
+		while ((skb = __skb_dequeue(skbs)) != NULL) {
+			dev_core_stats_rx_dropped_inc(dev);
+			kfree_skb(skb);
+		}
+		goto unlock;
+	}
+
+	if (!gcells->cells || netif_elide_gro(dev)) {
+		while ((skb = __skb_dequeue(skbs)) != NULL)
+			netif_rx(skb);
+		goto unlock;
+	}
+
+	cell = this_cpu_ptr(gcells->cells);
+	was_empty = skb_queue_empty(&cell->napi_skbs);
+
+	while ((skb = __skb_dequeue(skbs)) != NULL) {
+		if (skb_cloned(skb)) {
+			netif_rx(skb);
+			continue;
+		}
+
+		if (skb_queue_len(&cell->napi_skbs) >
+		    READ_ONCE(net_hotdata.max_backlog)) {
+			dev_core_stats_rx_dropped_inc(dev);
+			kfree_skb(skb);
+			continue;
+		}
+
+		__skb_queue_tail(&cell->napi_skbs, skb);
+	}
+
+	if (was_empty && !skb_queue_empty(&cell->napi_skbs))
+		napi_schedule(&cell->napi);
+
+unlock:
+	rcu_read_unlock();
+}
+EXPORT_SYMBOL(gro_cells_receive_list);
+
 /* called under BH context */
 static int gro_cell_poll(struct napi_struct *napi, int budget)
 {
@@ -244,7 +244,7 @@ static int neigh_forced_gc(struct neigh_table *tbl)
 {
 	int max_clean = atomic_read(&tbl->gc_entries) -
 			READ_ONCE(tbl->gc_thresh2);
-	u64 tmax = ktime_get_ns() + NSEC_PER_MSEC;
+	u64 start = ktime_get_ns(), tmax = start + NSEC_PER_MSEC;
 	unsigned long tref = jiffies - 5 * HZ;
 	struct neighbour *n, *tmp;
 	int shrunk = 0;
@@ -283,9 +283,19 @@ static int neigh_forced_gc(struct neigh_table *tbl)
 unlock:
 	write_unlock_bh(&tbl->lock);
 
+	NEIGH_CACHE_STAT_ADD(tbl, forced_gc_usecs,
+			     div_u64(ktime_get_ns() - start, NSEC_PER_USEC));
 	return shrunk;
 }
 
+static void neigh_forced_gc_work(struct work_struct *work)
+{
+	struct neigh_table *tbl = container_of(work, struct neigh_table,
+					       forced_gc_work);
+
+	neigh_forced_gc(tbl);
+}
+
 static void neigh_add_timer(struct neighbour *n, unsigned long when)
 {
 	/* Use safe distance from the jiffies - LONG_MAX point while timer
@@ -461,7 +471,11 @@ static struct neighbour *neigh_alloc(struct neigh_table *tbl,
 	if (entries >= gc_thresh3 ||
 	    (entries >= READ_ONCE(tbl->gc_thresh2) &&
 	     time_after(now, READ_ONCE(tbl->last_flush) + 5 * HZ))) {
-		if (!neigh_forced_gc(tbl) && entries >= gc_thresh3) {
+		/* Shrinking takes the table lock for up to a millisecond,
+		 * don't do it from the allocation path.
+		 */
+		queue_work(system_unbound_wq, &tbl->forced_gc_work);
+		if (entries >= gc_thresh3) {
 			net_info_ratelimited("%s: neighbor table overflow!\n",
 					     tbl->id);
 			NEIGH_CACHE_STAT_INC(tbl, table_fulls);
@@ -507,18 +521,19 @@ static void neigh_get_hash_rnd(u32 *x)
 	*x = get_random_u32() | 1;
 }
 
-static struct neigh_hash_table *neigh_hash_alloc(unsigned int shift)
+static struct neigh_hash_table *neigh_hash_alloc(unsigned int shift,
+						 gfp_t gfp)
 {
 	size_t size = (1 << shift) * sizeof(struct hlist_head);
 	struct hlist_head *hash_heads;
 	struct neigh_hash_table *ret;
 	int i;
 
-	ret = kmalloc(sizeof(*ret), GFP_ATOMIC);
+	ret = kmalloc(sizeof(*ret), gfp);
 	if (!ret)
 		return NULL;
 
-	hash_heads = kvzalloc(size, GFP_ATOMIC);
+	hash_heads = kvzalloc(size, gfp);
 	if (!hash_heads) {
 		kfree(ret);
 		return NULL;
@@ -530,30 +545,29 @@ static struct neigh_hash_table *neigh_hash_alloc(unsigned int shift)
 	return ret;
 }
 
+static void neigh_hash_free(struct neigh_hash_table *nht)
+{
+	kvfree(nht->hash_heads);
+	kfree(nht);
+}
+
 static void neigh_hash_free_rcu(struct rcu_head *head)
 {
 	struct neigh_hash_table *nht = container_of(head,
 						    struct neigh_hash_table,
 						    rcu);
 
-	kvfree(nht->hash_heads);
-	kfree(nht);
+	neigh_hash_free(nht);
 }
 
-static struct neigh_hash_table *neigh_hash_grow(struct neigh_table *tbl,
-						unsigned long new_shift)
+static void neigh_hash_grow(struct neigh_table *tbl,
+			    struct neigh_hash_table *old_nht,
+			    struct neigh_hash_table *new_nht)
 {
 	unsigned int i, hash;
-	struct neigh_hash_table *new_nht, *old_nht;
 
 	NEIGH_CACHE_STAT_INC(tbl, hash_grows);
 
-	old_nht = rcu_dereference_protected(tbl->nht,
-					    lockdep_is_held(&tbl->lock));
-	new_nht = neigh_hash_alloc(new_shift);
-	if (!new_nht)
-		return old_nht;
-
 	for (i = 0; i < (1 << old_nht->hash_shift); i++) {
 		struct hlist_node *tmp;
 		struct neighbour *n;
@@ -571,7 +585,47 @@ static struct neigh_hash_table *neigh_hash_grow(struct neigh_table *tbl,
 
 	rcu_assign_pointer(tbl->nht, new_nht);
 	call_rcu(&old_nht->rcu, neigh_hash_free_rcu);
-	return new_nht;
+}
+
+/* Resizes run from a work item, so that neither the allocation of the new
+ * buckets nor the rehash stall a neighbour being created. Until the work
+ * ran, new entries go to the current table.
+ */
+static void neigh_hash_grow_work(struct work_struct *work)
+{
+	struct neigh_table *tbl = container_of(work, struct neigh_table,
+					       hash_grow_work);
+	struct neigh_hash_table *old_nht, *new_nht;
+	unsigned int shift, new_shift;
+	u64 start;
+
+	rcu_read_lock();
+	shift = rcu_dereference(tbl->nht)->hash_shift;
+	rcu_read_unlock();
+
+	new_shift = shift + 1;
+	while ((1U << new_shift) < atomic_read(&tbl->entries) &&
+	       new_shift < 31)
+		new_shift++;
+
+	new_nht = neigh_hash_alloc(new_shift, GFP_KERNEL);
+	if (!new_nht)
+		return;
+
+	write_lock_bh(&tbl->lock);
+	start = ktime_get_ns();
+	old_nht = rcu_dereference_protected(tbl->nht,
+					    lockdep_is_held(&tbl->lock));
+	if (old_nht->hash_shift != shift) {
+		write_unlock_bh(&tbl->lock);
+		neigh_hash_free(new_nht);
+		return;
+	}
+	neigh_hash_grow(tbl, old_nht, new_nht);
+	write_unlock_bh(&tbl->lock);
+
+	NEIGH_CACHE_STAT_ADD(tbl, hash_grow_usecs,
+			     div_u64(ktime_get_ns() - start, NSEC_PER_USEC));
 }
 
 struct neighbour *neigh_lookup(struct neigh_table *tbl, const void *pkey,
@@ -643,7 +697,7 @@ ___neigh_create(struct neigh_table *tbl, const void *pkey,
 					lockdep_is_held(&tbl->lock));
 
 	if (atomic_read(&tbl->entries) > (1 << nht->hash_shift))
-		nht = neigh_hash_grow(tbl, nht->hash_shift + 1);
+		queue_work(system_unbound_wq, &tbl->hash_grow_work);
 
 	hash_val = tbl->hash(n->primary_key, dev, nht->hash_rnd) >> (32 - nht->hash_shift);
 
@@ -1748,7 +1802,7 @@ void neigh_table_init(int index, struct neigh_table *tbl)
 		panic("cannot create neighbour proc dir entry");
 #endif
 
-	RCU_INIT_POINTER(tbl->nht, neigh_hash_alloc(3));
+	RCU_INIT_POINTER(tbl->nht, neigh_hash_alloc(3, GFP_KERNEL));
 
 	phsize = (PNEIGH_HASHMASK + 1) * sizeof(struct pneigh_entry *);
 	tbl->phash_buckets = kzalloc(phsize, GFP_KERNEL);
@@ -1769,6 +1823,8 @@ void neigh_table_init(int index, struct neigh_table *tbl)
 			tbl->parms.reachable_time);
 	INIT_DEFERRABLE_WORK(&tbl->managed_work, neigh_managed_work);
 	queue_delayed_work(system_power_efficient_wq, &tbl->managed_work, 0);
+	INIT_WORK(&tbl->forced_gc_work, neigh_forced_gc_work);
+	INIT_WORK(&tbl->hash_grow_work, neigh_hash_grow_work);
 
 	timer_setup(&tbl->proxy_timer, neigh_proxy_process, 0);
 	skb_queue_head_init_class(&tbl->proxy_queue,
@@ -1793,6 +1849,8 @@ int neigh_table_clear(int index, struct neigh_table *tbl)
 	/* It is not clean... Fix it to unload IPv6 module safely */
 	cancel_delayed_work_sync(&tbl->managed_work);
 	cancel_delayed_work_sync(&tbl->gc_work);
+	cancel_work_sync(&tbl->forced_gc_work);
+	cancel_work_sync(&tbl->hash_grow_work);
 	del_timer_sync(&tbl->proxy_timer);
 	pneigh_queue_purge(&tbl->proxy_queue, NULL, tbl->family);
 	neigh_ifdown(tbl, NULL);
@@ -3406,13 +3464,14 @@ static int neigh_stat_seq_show(struct seq_file *seq, void *v)
 	struct neigh_statistics *st = v;
 
 	if (v == SEQ_START_TOKEN) {
-		seq_puts(seq, "entries  allocs   destroys hash_grows lookups  hits     res_failed rcv_probes_mcast rcv_probes_ucast periodic_gc_runs forced_gc_runs unresolved_discards table_fulls\n");
+		seq_puts(seq, "entries  allocs   destroys hash_grows lookups  hits     res_failed rcv_probes_mcast rcv_probes_ucast periodic_gc_runs forced_gc_runs unresolved_discards table_fulls forced_gc_usecs hash_grow_usecs\n");
 		return 0;
 	}
 
 	seq_printf(seq, "%08x %08lx %08lx %08lx   %08lx %08lx %08lx   "
 			"%08lx         %08lx         %08lx         "
-			"%08lx       %08lx            %08lx\n",
+			"%08lx       %08lx            %08lx    "
+			"%08lx        %08lx\n",
 		   atomic_read(&tbl->entries),
 
 		   st->allocs,
@@ -3430,7 +3489,9 @@ static int neigh_stat_seq_show(struct seq_file *seq, void *v)
 		   st->periodic_gc_runs,
 		   st->forced_gc_runs,
 		   st->unres_discards,
-		   st->table_fulls
+		   st->table_fulls,
+		   st->forced_gc_usecs,
+		   st->hash_grow_usecs
 		   );
 
 	return 0;
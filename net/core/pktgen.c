@@ -240,6 +240,10 @@ static char *pkt_flag_names[] = {
 #define PKTGEN_MAGIC 0xbe9be955
 #define PG_PROC_DIR "pktgen"
 #define PGCTRL	    "pgctrl"
+#define PGRX	    "pgrx"
+
+#define PG_RX_MAX_QUEUES	256
+#define PG_RX_LAT_BUCKETS	24	/* log2(usec), the last one is open */
 
 #define MAX_CFLOWS  65536
 
@@ -449,9 +453,31 @@ struct pktgen_net {
 	struct net		*net;
 	struct proc_dir_entry	*proc_dir;
 	struct list_head	pktgen_threads;
+	struct pktgen_rx	*rx;	/* protected by pktgen_thread_lock */
 	bool			pktgen_exiting;
 };
 
+/* Receive side accounting of pktgen packets, one slot per rx queue */
+struct pktgen_rx_queue {
+	atomic64_t packets;
+	atomic64_t bytes;
+	atomic64_t first_ns;
+	atomic64_t last_ns;
+	atomic64_t lat_packets;	/* packets carrying a timestamp */
+	atomic64_t lat_sum;	/* usec */
+	atomic64_t lat_max;	/* usec */
+	atomic64_t lat_hist[PG_RX_LAT_BUCKETS];
+} ____cacheline_aligned_in_smp;
+
+struct pktgen_rx {
+	struct packet_type pt_ip;
+	struct packet_type pt_ipv6;
+	struct net_device *dev;
+	netdevice_tracker dev_tracker;
+	unsigned int nr_queues;
+	struct pktgen_rx_queue queues[] __counted_by(nr_queues);
+};
+
 struct pktgen_thread {
 	struct mutex if_lock;		/* for list of devices */
 	struct list_head if_list;	/* All device here */
@@ -488,6 +514,9 @@ static void pktgen_stop_all_threads(struct pktgen_net *pn);
 
 static void pktgen_stop(struct pktgen_thread *t);
 static void pktgen_clear_counters(struct pktgen_dev *pkt_dev);
+static int pktgen_rx_start(struct pktgen_net *pn, const char *ifname);
+static void pktgen_rx_stop(struct pktgen_net *pn, struct net_device *dev);
+static void pktgen_rx_reset(struct pktgen_net *pn);
 static void fill_imix_distribution(struct pktgen_dev *pkt_dev);
 
 /* Module parameters, defaults. */
@@ -558,6 +587,113 @@ static const struct proc_ops pktgen_proc_ops = {
 	.proc_release	= single_release,
 };
 
+static int pgrx_show(struct seq_file *seq, void *v)
+{
+	struct pktgen_net *pn = seq->private;
+	struct pktgen_rx *rx;
+	unsigned int i, b;
+
+	mutex_lock(&pktgen_thread_lock);
+	rx = pn->rx;
+	if (!rx) {
+		seq_puts(seq, "RX: off\n");
+		goto out;
+	}
+
+	seq_printf(seq, "RX: %s queues: %u\n", rx->dev->name, rx->nr_queues);
+	for (i = 0; i < rx->nr_queues; i++) {
+		struct pktgen_rx_queue *q = &rx->queues[i];
+		u64 pkts = atomic64_read(&q->packets);
+		u64 bytes = atomic64_read(&q->bytes);
+		u64 elapsed, lat_pkts, pps = 0, mbps = 0;
+
+		if (!pkts)
+			continue;
+
+		elapsed = atomic64_read(&q->last_ns) -
+			  atomic64_read(&q->first_ns);
+		if (elapsed) {
+			pps = div64_u64((pkts - 1) * NSEC_PER_SEC, elapsed);
+			mbps = div64_u64(bytes * 8 * (NSEC_PER_SEC / 1000000),
+					 elapsed);
+		}
+		seq_printf(seq, "queue %u: pkts: %llu bytes: %llu %llupps %lluMb/sec\n",
+			   i, pkts, bytes, pps, mbps);
+
+		lat_pkts = atomic64_read(&q->lat_packets);
+		if (!lat_pkts)
+			continue;
+
+		seq_printf(seq, "  latency: pkts: %llu avg: %lluus max: %lluus\n",
+			   lat_pkts,
+			   div64_u64(atomic64_read(&q->lat_sum), lat_pkts),
+			   (u64)atomic64_read(&q->lat_max));
+		for (b = 0; b < PG_RX_LAT_BUCKETS; b++) {
+			u64 cnt = atomic64_read(&q->lat_hist[b]);
+
+			if (!cnt)
+				continue;
+			if (!b)
+				seq_printf(seq, "    <1us: %llu\n", cnt);
+			else if (b == PG_RX_LAT_BUCKETS - 1)
+				seq_printf(seq, "    >=%lluus: %llu\n",
+					   1ULL << (b - 1), cnt);
+			else
+				seq_printf(seq, "    %llu-%lluus: %llu\n",
+					   1ULL << (b - 1), (1ULL << b) - 1, cnt);
+		}
+	}
+out:
+	mutex_unlock(&pktgen_thread_lock);
+	return 0;
+}
+
+static ssize_t pgrx_write(struct file *file, const char __user *buf,
+			  size_t count, loff_t *ppos)
+{
+	struct pktgen_net *pn = net_generic(current->nsproxy->net_ns, pg_net_id);
+	char data[IFNAMSIZ + 4];
+	int ret = 0;
+
+	if (!capable(CAP_NET_ADMIN))
+		return -EPERM;
+
+	if (count == 0)
+		return -EINVAL;
+
+	if (count > sizeof(data))
+		count = sizeof(data);
+
+	if (copy_from_user(data, buf, count))
+		return -EFAULT;
+
+	data[count - 1] = 0;	/* Strip trailing '\n' and terminate string */
+
+	if (!strncmp(data, "rx ", 3))
+		ret = pktgen_rx_start(pn, data + 3);
+	else if (!strcmp(data, "rx_reset"))
+		pktgen_rx_reset(pn);
+	else if (!strcmp(data, "rx_stop"))
+		pktgen_rx_stop(pn, NULL);
+	else
+		return -EINVAL;
+
+	return ret ? ret : count;
+}
+
+static int pgrx_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, pgrx_show, pde_data(inode));
+}
+
+static const struct proc_ops pktgen_rx_proc_ops = {
+	.proc_open	= pgrx_open,
+	.proc_read	= seq_read,
+	.proc_lseek	= seq_lseek,
+	.proc_write	= pgrx_write,
+	.proc_release	= single_release,
+};
+
 static int pktgen_if_show(struct seq_file *seq, void *v)
 {
 	const struct pktgen_dev *pkt_dev = seq->private;
@@ -2086,6 +2222,7 @@ static int pktgen_device_event(struct notifier_block *unused,
 
 	case NETDEV_UNREGISTER:
 		pktgen_mark_device(pn, dev->name);
+		pktgen_rx_stop(pn, dev);
 		break;
 	}
 
@@ -3152,6 +3289,190 @@ static void pktgen_clear_counters(struct pktgen_dev *pkt_dev)
 	pkt_dev->errors = 0;
 }
 
+/* Account a received pktgen packet, @off is the offset of the pktgen
+ * header from the network header. Packets of any pktgen_dev are counted,
+ * the timestamp stamped at transmit gives the one way latency, with the
+ * microsecond precision of the header.
+ */
+static void pktgen_rx_account(struct pktgen_rx *rx, struct sk_buff *skb,
+			      unsigned int off)
+{
+	const struct pktgen_hdr *pgh;
+	struct pktgen_rx_queue *q;
+	struct pktgen_hdr _pgh;
+	struct timespec64 now;
+	u64 ns, old;
+	s64 lat;
+	u16 qid = 0;
+
+	pgh = skb_header_pointer(skb, off, sizeof(_pgh), &_pgh);
+	if (!pgh || pgh->pgh_magic != htonl(PKTGEN_MAGIC))
+		return;
+
+	if (skb_rx_queue_recorded(skb))
+		qid = skb_get_rx_queue(skb);
+	q = &rx->queues[qid % rx->nr_queues];
+
+	ns = ktime_get_ns();
+	atomic64_inc(&q->packets);
+	atomic64_add(skb->len + skb->mac_len, &q->bytes);
+	atomic64_cmpxchg(&q->first_ns, 0, ns);
+	atomic64_set(&q->last_ns, ns);
+
+	/* F_NO_TIMESTAMP */
+	if (!pgh->tv_sec && !pgh->tv_usec)
+		return;
+
+	ktime_get_real_ts64(&now);
+	lat = (s64)(s32)((u32)now.tv_sec - ntohl(pgh->tv_sec)) * USEC_PER_SEC +
+	      now.tv_nsec / NSEC_PER_USEC - (s64)ntohl(pgh->tv_usec);
+	if (lat < 0)
+		lat = 0;
+
+	atomic64_inc(&q->lat_packets);
+	atomic64_add(lat, &q->lat_sum);
+	atomic64_inc(&q->lat_hist[min(fls64(lat), PG_RX_LAT_BUCKETS - 1)]);
+	old = atomic64_read(&q->lat_max);
+	while (lat > old && !atomic64_try_cmpxchg(&q->lat_max, &old, lat))
+		;
+}
+
+static int pktgen_rx_ip(struct sk_buff *skb, struct net_device *dev,
+			struct packet_type *pt, struct net_device *orig_dev)
+{
+	struct pktgen_rx *rx = container_of(pt, struct pktgen_rx, pt_ip);
+	const struct iphdr *iph;
+	struct iphdr _iph;
+
+	iph = skb_header_pointer(skb, 0, sizeof(_iph), &_iph);
+	if (iph && iph->ihl >= 5 && iph->protocol == IPPROTO_UDP &&
+	    !ip_is_fragment(iph))
+		pktgen_rx_account(rx, skb, iph->ihl * 4 + sizeof(struct udphdr));
+
+	consume_skb(skb);
+	return NET_RX_SUCCESS;
+}
+
+static int pktgen_rx_ipv6(struct sk_buff *skb, struct net_device *dev,
+			  struct packet_type *pt, struct net_device *orig_dev)
+{
+	struct pktgen_rx *rx = container_of(pt, struct pktgen_rx, pt_ipv6);
+	const struct ipv6hdr *ip6h;
+	struct ipv6hdr _ip6h;
+
+	/* pktgen never adds extension headers */
+	ip6h = skb_header_pointer(skb, 0, sizeof(_ip6h), &_ip6h);
+	if (ip6h && ip6h->nexthdr == IPPROTO_UDP)
+		pktgen_rx_account(rx, skb,
+				  sizeof(struct ipv6hdr) + sizeof(struct udphdr));
+
+	consume_skb(skb);
+	return NET_RX_SUCCESS;
+}
+
+/* Hook the receive path of @ifname. The handlers are bound to the device,
+ * so traffic on other devices does not pay for them.
+ */
+static int pktgen_rx_start(struct pktgen_net *pn, const char *ifname)
+{
+	struct net_device *dev;
+	struct pktgen_rx *rx;
+	unsigned int nr;
+
+	pktgen_rx_stop(pn, NULL);
+
+	/* Hold RTNL from the lookup until the hook is installed, so an
+	 * unregister either happens before the lookup or finds pn->rx set
+	 * and unhooks it from pktgen_device_event().
+	 */
+	rtnl_lock();
+	dev = __dev_get_by_name(pn->net, ifname);
+	if (!dev) {
+		rtnl_unlock();
+		pr_err("no such netdevice: \"%s\"\n", ifname);
+		return -ENODEV;
+	}
+
+	nr = clamp_t(unsigned int, dev->real_num_rx_queues, 1, PG_RX_MAX_QUEUES);
+	rx = kvzalloc(struct_size(rx, queues, nr), GFP_KERNEL);
+	if (!rx) {
+		rtnl_unlock();
+		return -ENOMEM;
+	}
+	rx->nr_queues = nr;
+	rx->dev = dev;
+	netdev_hold(dev, &rx->dev_tracker, GFP_KERNEL);
+
+	rx->pt_ip.type = htons(ETH_P_IP);
+	rx->pt_ip.dev = dev;
+	rx->pt_ip.func = pktgen_rx_ip;
+	rx->pt_ipv6.type = htons(ETH_P_IPV6);
+	rx->pt_ipv6.dev = dev;
+	rx->pt_ipv6.func = pktgen_rx_ipv6;
+
+	mutex_lock(&pktgen_thread_lock);
+	if (pn->rx) {
+		/* raced with another start */
+		mutex_unlock(&pktgen_thread_lock);
+		rtnl_unlock();
+		netdev_put(dev, &rx->dev_tracker);
+		kvfree(rx);
+		return -EBUSY;
+	}
+	pn->rx = rx;
+	dev_add_pack(&rx->pt_ip);
+	dev_add_pack(&rx->pt_ipv6);
+	mutex_unlock(&pktgen_thread_lock);
+	rtnl_unlock();
+
+	return 0;
+}
+
+/* Unhook the receive path, if @dev is set only when it is hooked to it */
+static void pktgen_rx_stop(struct pktgen_net *pn, struct net_device *dev)
+{
+	struct pktgen_rx *rx;
+
+	mutex_lock(&pktgen_thread_lock);
+	rx = pn->rx;
+	if (rx && (!dev || rx->dev == dev))
+		pn->rx = NULL;
+	else
+		rx = NULL;
+	mutex_unlock(&pktgen_thread_lock);
+
+	if (!rx)
+		return;
+
+	dev_remove_pack(&rx->pt_ip);
+	dev_remove_pack(&rx->pt_ipv6);
+	netdev_put(rx->dev, &rx->dev_tracker);
+	kvfree(rx);
+}
+
+static void pktgen_rx_reset(struct pktgen_net *pn)
+{
+	struct pktgen_rx *rx;
+	unsigned int i, b;
+
+	mutex_lock(&pktgen_thread_lock);
+	rx = pn->rx;
+	for (i = 0; rx && i < rx->nr_queues; i++) {
+		struct pktgen_rx_queue *q = &rx->queues[i];
+
+		atomic64_set(&q->packets, 0);
+		atomic64_set(&q->bytes, 0);
+		atomic64_set(&q->first_ns, 0);
+		atomic64_set(&q->last_ns, 0);
+		atomic64_set(&q->lat_packets, 0);
+		atomic64_set(&q->lat_sum, 0);
+		atomic64_set(&q->lat_max, 0);
+		for (b = 0; b < PG_RX_LAT_BUCKETS; b++)
+			atomic64_set(&q->lat_hist[b], 0);
+	}
+	mutex_unlock(&pktgen_thread_lock);
+}
+
 /* Set up structure for sending pkts, clear counters */
 
 static void pktgen_run(struct pktgen_thread *t)
@@ -3985,6 +4306,12 @@ static int __net_init pg_net_init(struct net *net)
 		ret = -EINVAL;
 		goto remove;
 	}
+	pe = proc_create_data(PGRX, 0600, pn->proc_dir, &pktgen_rx_proc_ops, pn);
+	if (pe == NULL) {
+		pr_err("cannot create %s procfs entry\n", PGRX);
+		ret = -EINVAL;
+		goto remove_entry;
+	}
 
 	cpus_read_lock();
 	for_each_online_cpu(cpu) {
@@ -4000,11 +4327,13 @@ static int __net_init pg_net_init(struct net *net)
 	if (list_empty(&pn->pktgen_threads)) {
 		pr_err("Initialization failed for all threads\n");
 		ret = -ENODEV;
-		goto remove_entry;
+		goto remove_rx_entry;
 	}
 
 	return 0;
 
+remove_rx_entry:
+	remove_proc_entry(PGRX, pn->proc_dir);
 remove_entry:
 	remove_proc_entry(PGCTRL, pn->proc_dir);
 remove:
@@ -4033,6 +4362,8 @@ static void __net_exit pg_net_exit(struct net *net)
 		kfree(t);
 	}
 
+	pktgen_rx_stop(pn, NULL);
+	remove_proc_entry(PGRX, pn->proc_dir);
 	remove_proc_entry(PGCTRL, pn->proc_dir);
 	remove_proc_entry(PG_PROC_DIR, pn->net->proc_net);
 }
@@ -515,7 +515,8 @@ static struct sk_msg *alloc_sk_msg(gfp_t gfp)
 }
 
 static struct sk_msg *sk_psock_create_ingress_msg(struct sock *sk,
-						  struct sk_buff *skb)
+						  struct sk_buff *skb,
+						  gfp_t gfp)
 {
 	if (atomic_read(&sk->sk_rmem_alloc) > sk->sk_rcvbuf)
 		return NULL;
@@ -523,7 +524,7 @@ static struct sk_msg *sk_psock_create_ingress_msg(struct sock *sk,
 	if (!sk_rmem_schedule(sk, skb, skb->truesize))
 		return NULL;
 
-	return alloc_sk_msg(GFP_KERNEL);
+	return alloc_sk_msg(gfp);
 }
 
 static int sk_psock_skb_ingress_enqueue(struct sk_buff *skb,
@@ -564,7 +565,7 @@ static int sk_psock_skb_ingress_self(struct sk_psock *psock, struct sk_buff *skb
 				     u32 off, u32 len);
 
 static int sk_psock_skb_ingress(struct sk_psock *psock, struct sk_buff *skb,
-				u32 off, u32 len)
+				u32 off, u32 len, gfp_t gfp)
 {
 	struct sock *sk = psock->sk;
 	struct sk_msg *msg;
@@ -576,7 +577,7 @@ static int sk_psock_skb_ingress(struct sk_psock *psock, struct sk_buff *skb,
 	 */
 	if (unlikely(skb->sk == sk))
 		return sk_psock_skb_ingress_self(psock, skb, off, len);
-	msg = sk_psock_create_ingress_msg(sk, skb);
+	msg = sk_psock_create_ingress_msg(sk, skb, gfp);
 	if (!msg)
 		return -EAGAIN;
 
@@ -624,7 +625,7 @@ static int sk_psock_handle_skb(struct sk_psock *psock, struct sk_buff *skb,
 		return skb_send_sock(psock->sk, skb, off, len);
 	}
 	skb_get(skb);
-	err = sk_psock_skb_ingress(psock, skb, off, len);
+	err = sk_psock_skb_ingress(psock, skb, off, len, GFP_KERNEL);
 	if (err < 0)
 		kfree_skb(skb);
 	return err;
@@ -906,10 +907,50 @@ int sk_psock_msg_verdict(struct sock *sk, struct sk_psock *psock,
 }
 EXPORT_SYMBOL_GPL(sk_psock_msg_verdict);
 
+/* Redirects to the ingress of another socket are put on its receive queue
+ * right away instead of taking the backlog work hop when its socket lock
+ * can be had without waiting, like the receive path of the socket itself
+ * does. The lock serializes the receive memory accounting with the
+ * socket's own receive path and its owner. Only trylock it, a redirect in
+ * the other direction may hold it and wait for ours. This is only done
+ * while nothing is pending in the backlog, to keep the data in order.
+ * When the lock is busy or the receiver is over its limits -EAGAIN is
+ * returned and the backlog takes over, which retries until the receiver
+ * catches up.
+ */
+static int sk_psock_skb_redirect_ingress(struct sk_psock *psock,
+					 struct sk_buff *skb)
+{
+	struct sock *sk = psock->sk;
+	u32 off = 0, len = skb->len;
+	int err = -EAGAIN;
+
+	if (skb_bpf_strparser(skb)) {
+		struct strp_msg *stm = strp_msg(skb);
+
+		off = stm->offset;
+		len = stm->full_len;
+	}
+
+	if (!spin_trylock_bh(&sk->sk_lock.slock))
+		return -EAGAIN;
+	if (sock_owned_by_user(sk))
+		goto out;
+
+	skb_bpf_redirect_clear(skb);
+	err = sk_psock_skb_ingress(psock, skb, off, len, GFP_ATOMIC);
+	if (err < 0)
+		skb_bpf_set_ingress(skb);
+out:
+	spin_unlock_bh(&sk->sk_lock.slock);
+	return err;
+}
+
 static int sk_psock_skb_redirect(struct sk_psock *from, struct sk_buff *skb)
 {
 	struct sk_psock *psock_other;
 	struct sock *sk_other;
+	bool inline_ok;
 
 	sk_other = skb_bpf_redirect_fetch(skb);
 	/* This error is a buggy BPF program, it returned a redirect
@@ -937,7 +978,20 @@ static int sk_psock_skb_redirect(struct sk_psock *from, struct sk_buff *skb)
 		sock_drop(from->sk, skb);
 		return -EIO;
 	}
+	inline_ok = skb_bpf_ingress(skb) &&
+		    skb_queue_empty(&psock_other->ingress_skb);
+	spin_unlock_bh(&psock_other->ingress_lock);
+
+	if (inline_ok && sk_psock_skb_redirect_ingress(psock_other, skb) > 0)
+		return 0;
 
+	spin_lock_bh(&psock_other->ingress_lock);
+	if (!sk_psock_test_state(psock_other, SK_PSOCK_TX_ENABLED)) {
+		spin_unlock_bh(&psock_other->ingress_lock);
+		skb_bpf_redirect_clear(skb);
+		sock_drop(from->sk, skb);
+		return -EIO;
+	}
 	skb_queue_tail(&psock_other->ingress_skb, skb);
 	schedule_delayed_work(&psock_other->work, 0);
 	spin_unlock_bh(&psock_other->ingress_lock);
@@ -21,7 +21,7 @@ static DEFINE_MUTEX(dsa_tag_drivers_lock);
 
 /* Determine if we should defer delivery of skb until we have a rx timestamp.
  *
- * Called from dsa_switch_rcv. For now, this will only work if tagging is
+ * Called from dsa_user_rcv. For now, this will only work if tagging is
  * enabled on the switch. Normally the MAC driver would retrieve the hardware
  * timestamp when it reads the packet out of the hardware. However in a DSA
  * switch, the DSA driver owning the interface to which the packet is
@@ -51,22 +51,25 @@ static bool dsa_skb_defer_rx_timestamp(struct dsa_user_priv *p,
 	return ds->ops->port_rxtstamp(ds, p->dp->index, skb, type);
 }
 
-static int dsa_switch_rcv(struct sk_buff *skb, struct net_device *dev,
-			  struct packet_type *pt, struct net_device *unused)
+/* Strip the switch tag and find the user port the skb belongs to. Returns
+ * the skb if it is to be delivered to a DSA user port, NULL if it was
+ * consumed or dropped.
+ */
+static struct sk_buff *dsa_switch_rcv_one(struct sk_buff *skb,
+					  struct net_device *dev)
 {
 	struct metadata_dst *md_dst = skb_metadata_dst(skb);
 	struct dsa_port *cpu_dp = dev->dsa_ptr;
 	struct sk_buff *nskb = NULL;
-	struct dsa_user_priv *p;
 
 	if (unlikely(!cpu_dp)) {
 		kfree_skb(skb);
-		return 0;
+		return NULL;
 	}
 
 	skb = skb_unshare(skb, GFP_ATOMIC);
 	if (!skb)
-		return 0;
+		return NULL;
 
 	if (md_dst && md_dst->type == METADATA_HW_PORT_MUX) {
 		unsigned int port = md_dst->u.port_info.port_id;
@@ -86,7 +89,7 @@ static int dsa_switch_rcv(struct sk_buff *skb, struct net_device *dev,
 
 	if (!nskb) {
 		kfree_skb(skb);
-		return 0;
+		return NULL;
 	}
 
 	skb = nskb;
@@ -100,34 +103,93 @@ static int dsa_switch_rcv(struct sk_buff *skb, struct net_device *dev,
 		 * specific actions.
 		 */
 		netif_rx(skb);
-		return 0;
+		return NULL;
 	}
 
-	p = netdev_priv(skb->dev);
-
 	if (unlikely(cpu_dp->ds->untag_bridge_pvid ||
 		     cpu_dp->ds->untag_vlan_aware_bridge_pvid)) {
 		nskb = dsa_software_vlan_untag(skb);
 		if (!nskb) {
 			kfree_skb(skb);
-			return 0;
+			return NULL;
 		}
 		skb = nskb;
 	}
 
-	dev_sw_netstats_rx_add(skb->dev, skb->len + ETH_HLEN);
+	return skb;
+}
+
+static void dsa_user_rcv(struct sk_buff *skb)
+{
+	struct dsa_user_priv *p = netdev_priv(skb->dev);
 
 	if (dsa_skb_defer_rx_timestamp(p, skb))
-		return 0;
+		return;
 
 	gro_cells_receive(&p->gcells, skb);
+}
+
+static int dsa_switch_rcv(struct sk_buff *skb, struct net_device *dev,
+			  struct packet_type *pt, struct net_device *unused)
+{
+	skb = dsa_switch_rcv_one(skb, dev);
+	if (!skb)
+		return 0;
+
+	dev_sw_netstats_rx_add(skb->dev, skb->len + ETH_HLEN);
+	dsa_user_rcv(skb);
 
 	return 0;
 }
 
+static void dsa_user_rcv_list(struct sk_buff_head *skbs)
+{
+	struct dsa_user_priv *p;
+
+	if (skb_queue_empty(skbs))
+		return;
+
+	p = netdev_priv(skb_peek(skbs)->dev);
+	gro_cells_receive_list(&p->gcells, skbs);
+}
+
+/* List variant used when the conduit receives with netif_receive_skb_list()
+ * or GRO. Frames of the same user port tend to arrive back to back, so
+ * each such run is handed to the user port's GRO cell at once.
+ */
+static void dsa_switch_rcv_list(struct list_head *head, struct packet_type *pt,
+				struct net_device *orig_dev)
+{
+	struct sk_buff *skb, *next;
+	struct sk_buff_head run;
+
+	__skb_queue_head_init(&run);
+
+	list_for_each_entry_safe(skb, next, head, list) {
+		skb_list_del_init(skb);
+
+		skb = dsa_switch_rcv_one(skb, skb->dev);
+		if (!skb)
+			continue;
+
+		dev_sw_netstats_rx_add(skb->dev, skb->len + ETH_HLEN);
+
+		if (dsa_skb_defer_rx_timestamp(netdev_priv(skb->dev), skb))
+			continue;
+
+		if (!skb_queue_empty(&run) && skb_peek(&run)->dev != skb->dev)
+			dsa_user_rcv_list(&run);
+
+		__skb_queue_tail(&run, skb);
+	}
+
+	dsa_user_rcv_list(&run);
+}
+
 struct packet_type dsa_pack_type __read_mostly = {
 	.type	= cpu_to_be16(ETH_P_XDSA),
 	.func	= dsa_switch_rcv,
+	.list_func = dsa_switch_rcv_list,
 };
 
 static void dsa_tag_driver_register(struct dsa_tag_driver *dsa_tag_driver,
@@ -430,6 +430,53 @@ static void handshake_req_cancel_test3(struct kunit *test)
 	fput(filp);
 }
 
+static void handshake_req_next_test1(struct kunit *test)
+{
+	struct handshake_req *req, *next;
+	long submitted, accepted;
+	struct handshake_net *hn;
+	struct socket *sock;
+	struct file *filp;
+	struct net *net;
+	int err;
+
+	/* Arrange */
+	req = handshake_req_alloc(&handshake_req_alloc_proto_good, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, req);
+
+	err = __sock_create(&init_net, PF_INET, SOCK_STREAM, IPPROTO_TCP,
+			    &sock, 1);
+	KUNIT_ASSERT_EQ(test, err, 0);
+
+	filp = sock_alloc_file(sock, O_NONBLOCK, NULL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, filp);
+	sock->file = filp;
+
+	net = sock_net(sock->sk);
+	hn = handshake_pernet(net);
+	KUNIT_ASSERT_NOT_NULL(test, hn);
+
+	submitted = atomic_long_read(&hn->hn_submitted);
+	accepted = atomic_long_read(&hn->hn_accepted);
+
+	err = handshake_req_submit(sock, req, GFP_KERNEL);
+	KUNIT_ASSERT_EQ(test, err, 0);
+
+	/* Act */
+	next = handshake_req_next(hn, HANDSHAKE_HANDLER_CLASS_TLSHD);
+
+	/* Assert */
+	KUNIT_EXPECT_PTR_EQ(test, req, next);
+	KUNIT_EXPECT_EQ(test, atomic_long_read(&hn->hn_submitted),
+			submitted + 1);
+	KUNIT_EXPECT_EQ(test, atomic_long_read(&hn->hn_accepted),
+			accepted + 1);
+	KUNIT_EXPECT_GE(test, hn->hn_pending_peak, 1);
+
+	handshake_req_cancel(sock->sk);
+	fput(filp);
+}
+
 static struct handshake_req *handshake_req_destroy_test;
 
 static void test_destroy_func(struct handshake_req *req)
@@ -522,6 +569,10 @@ static struct kunit_case handshake_api_test_cases[] = {
 		.name			= "req_cancel after done",
 		.run_case		= handshake_req_cancel_test3,
 	},
+	{
+		.name			= "req_next updates counters",
+		.run_case		= handshake_req_next_test1,
+	},
 	{
 		.name			= "req_destroy works",
 		.run_case		= handshake_req_destroy_test1,
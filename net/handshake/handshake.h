@@ -10,14 +10,28 @@
 #ifndef _INTERNAL_HANDSHAKE_H
 #define _INTERNAL_HANDSHAKE_H
 
+#include <uapi/linux/handshake.h>
+
 /* Per-net namespace context */
 struct handshake_net {
-	spinlock_t		hn_lock;	/* protects next 3 fields */
+	spinlock_t		hn_lock;	/* protects next 4 fields */
 	int			hn_pending;
 	int			hn_pending_max;
+	int			hn_pending_peak;
 	struct list_head	hn_requests;
 
 	unsigned long		hn_flags;
+
+	/* handler classes with a READY notification not yet accepted,
+	 * and when that READY was sent; both protected by hn_lock
+	 */
+	unsigned long		hn_notified;
+	unsigned long		hn_notify_time[HANDSHAKE_HANDLER_CLASS_MAX];
+
+	atomic_long_t		hn_submitted;
+	atomic_long_t		hn_accepted;
+	atomic_long_t		hn_rejected;
+	atomic_long_t		hn_coalesced;
 };
 
 enum hn_flags_bits {
@@ -84,6 +98,8 @@ void handshake_req_hash_destroy(void);
 void *handshake_req_private(struct handshake_req *req);
 struct handshake_req *handshake_req_hash_lookup(struct sock *sk);
 struct handshake_req *handshake_req_next(struct handshake_net *hn, int class);
+void handshake_req_notify_next(struct net *net, struct handshake_net *hn,
+			       int class);
 int handshake_req_submit(struct socket *sock, struct handshake_req *req,
 			 gfp_t flags);
 void handshake_complete(struct handshake_req *req, unsigned int status,
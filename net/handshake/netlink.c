@@ -13,6 +13,8 @@
 #include <linux/module.h>
 #include <linux/skbuff.h>
 #include <linux/mm.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
 
 #include <net/sock.h>
 #include <net/genetlink.h>
@@ -106,6 +108,7 @@ int handshake_nl_accept_doit(struct sk_buff *skb, struct genl_info *info)
 
 	err = -EAGAIN;
 	req = handshake_req_next(hn, class);
+	handshake_req_notify_next(net, hn, class);
 	if (!req)
 		goto out_status;
 
@@ -170,6 +173,46 @@ int handshake_nl_done_doit(struct sk_buff *skb, struct genl_info *info)
 
 static unsigned int handshake_net_id;
 
+#ifdef CONFIG_PROC_FS
+static int handshake_proc_show(struct seq_file *seq, void *v)
+{
+	struct handshake_net *hn = net_generic(seq_file_net(seq),
+					       handshake_net_id);
+
+	seq_printf(seq, "pending %d max %d peak %d\n",
+		   READ_ONCE(hn->hn_pending), hn->hn_pending_max,
+		   READ_ONCE(hn->hn_pending_peak));
+	seq_printf(seq, "submitted %ld accepted %ld rejected %ld coalesced %ld\n",
+		   atomic_long_read(&hn->hn_submitted),
+		   atomic_long_read(&hn->hn_accepted),
+		   atomic_long_read(&hn->hn_rejected),
+		   atomic_long_read(&hn->hn_coalesced));
+	return 0;
+}
+
+static int __net_init handshake_proc_init(struct net *net)
+{
+	if (!proc_create_net_single("handshake", 0444, net->proc_net,
+				    handshake_proc_show, NULL))
+		return -ENOMEM;
+	return 0;
+}
+
+static void __net_exit handshake_proc_exit(struct net *net)
+{
+	remove_proc_entry("handshake", net->proc_net);
+}
+#else
+static int __net_init handshake_proc_init(struct net *net)
+{
+	return 0;
+}
+
+static void __net_exit handshake_proc_exit(struct net *net)
+{
+}
+#endif
+
 static int __net_init handshake_net_init(struct net *net)
 {
 	struct handshake_net *hn = net_generic(net, handshake_net_id);
@@ -187,9 +230,17 @@ static int __net_init handshake_net_init(struct net *net)
 
 	spin_lock_init(&hn->hn_lock);
 	hn->hn_pending = 0;
+	hn->hn_pending_peak = 0;
 	hn->hn_flags = 0;
+	hn->hn_notified = 0;
 	INIT_LIST_HEAD(&hn->hn_requests);
-	return 0;
+
+	atomic_long_set(&hn->hn_submitted, 0);
+	atomic_long_set(&hn->hn_accepted, 0);
+	atomic_long_set(&hn->hn_rejected, 0);
+	atomic_long_set(&hn->hn_coalesced, 0);
+
+	return handshake_proc_init(net);
 }
 
 static void __net_exit handshake_net_exit(struct net *net)
@@ -198,6 +249,8 @@ static void __net_exit handshake_net_exit(struct net *net)
 	struct handshake_req *req;
 	LIST_HEAD(requests);
 
+	handshake_proc_exit(net);
+
 	/*
 	 * Drain the net's pending list. Requests that have been
 	 * accepted and are in progress will be destroyed when
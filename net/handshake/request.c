@@ -23,9 +23,13 @@
 
 #include <uapi/linux/handshake.h>
 #include "handshake.h"
+#include "genl.h"
 
 #include <trace/events/handshake.h>
 
+/* How long an outstanding READY may go unaccepted before it is resent */
+#define HANDSHAKE_NOTIFY_TIMEOUT	(2 * HZ)
+
 /*
  * We need both a handshake_req -> sock mapping, and a sock ->
  * handshake_req mapping. Both are one-to-one.
@@ -146,6 +150,8 @@ static bool __add_pending_locked(struct handshake_net *hn,
 	if (WARN_ON_ONCE(!list_empty(&req->hr_list)))
 		return false;
 	hn->hn_pending++;
+	if (hn->hn_pending > hn->hn_pending_peak)
+		hn->hn_pending_peak = hn->hn_pending;
 	list_add_tail(&req->hr_list, &hn->hn_requests);
 	return true;
 }
@@ -192,10 +198,51 @@ struct handshake_req *handshake_req_next(struct handshake_net *hn, int class)
 	}
 	spin_unlock(&hn->hn_lock);
 
+	if (req)
+		atomic_long_inc(&hn->hn_accepted);
 	return req;
 }
 EXPORT_SYMBOL_IF_KUNIT(handshake_req_next);
 
+/**
+ * handshake_req_notify_next - Pass the READY notification on
+ * @net: target network namespace
+ * @hn: per-net handshake context
+ * @class: handler class of the request that was just accepted
+ *
+ * At most one READY notification per handler class is outstanding.
+ * Each ACCEPT consumes it, so send the next one here if more requests
+ * of @class are waiting. During a reconnect storm this keeps the agent's
+ * multicast socket from overflowing and dropping notifications, which
+ * would leave requests waiting until their consumers time out. A READY
+ * that is not accepted within HANDSHAKE_NOTIFY_TIMEOUT is taken as lost,
+ * and the next submission of @class sends a new one.
+ */
+void handshake_req_notify_next(struct net *net, struct handshake_net *hn,
+			       int class)
+{
+	const struct handshake_proto *proto = NULL;
+	struct handshake_req *pos;
+
+	spin_lock(&hn->hn_lock);
+	list_for_each_entry(pos, &hn->hn_requests, hr_list) {
+		if (pos->hr_proto->hp_handler_class != class)
+			continue;
+		proto = pos->hr_proto;
+		break;
+	}
+	if (proto) {
+		set_bit(class, &hn->hn_notified);
+		hn->hn_notify_time[class] = jiffies;
+	} else {
+		clear_bit(class, &hn->hn_notified);
+	}
+	spin_unlock(&hn->hn_lock);
+
+	if (proto && handshake_genl_notify(net, proto, GFP_KERNEL))
+		clear_bit(class, &hn->hn_notified);
+}
+
 /**
  * handshake_req_submit - Submit a handshake request
  * @sock: open socket on which to perform the handshake
@@ -223,8 +270,9 @@ int handshake_req_submit(struct socket *sock, struct handshake_req *req,
 			 gfp_t flags)
 {
 	struct handshake_net *hn;
+	bool notify = true;
 	struct net *net;
-	int ret;
+	int class, ret;
 
 	if (!sock || !req || !sock->file) {
 		kfree(req);
@@ -238,6 +286,7 @@ int handshake_req_submit(struct socket *sock, struct handshake_req *req,
 	}
 	req->hr_odestruct = req->hr_sk->sk_destruct;
 	req->hr_sk->sk_destruct = handshake_sk_destruct;
+	class = req->hr_proto->hp_handler_class;
 
 	ret = -EOPNOTSUPP;
 	net = sock_net(req->hr_sk);
@@ -246,8 +295,10 @@ int handshake_req_submit(struct socket *sock, struct handshake_req *req,
 		goto out_err;
 
 	ret = -EAGAIN;
-	if (READ_ONCE(hn->hn_pending) >= hn->hn_pending_max)
+	if (READ_ONCE(hn->hn_pending) >= hn->hn_pending_max) {
+		atomic_long_inc(&hn->hn_rejected);
 		goto out_err;
+	}
 
 	spin_lock(&hn->hn_lock);
 	ret = -EOPNOTSUPP;
@@ -258,9 +309,33 @@ int handshake_req_submit(struct socket *sock, struct handshake_req *req,
 		goto out_unlock;
 	if (!__add_pending_locked(hn, req))
 		goto out_unlock;
+	/* A READY for this class is already on its way to the agent, and
+	 * the ACCEPT that consumes it will pass it on to this request. If
+	 * it has not been accepted for too long it was probably dropped,
+	 * so send another rather than stall the class.
+	 */
+	if (test_bit(HANDSHAKE_F_PROTO_NOTIFY, &req->hr_proto->hp_flags)) {
+		notify = !test_and_set_bit(class, &hn->hn_notified) ||
+			 time_after(jiffies, hn->hn_notify_time[class] +
+					     HANDSHAKE_NOTIFY_TIMEOUT);
+		if (notify)
+			hn->hn_notify_time[class] = jiffies;
+	}
 	spin_unlock(&hn->hn_lock);
-
-	ret = handshake_genl_notify(net, req->hr_proto, flags);
+	atomic_long_inc(&hn->hn_submitted);
+
+	ret = 0;
+	if (notify) {
+		ret = handshake_genl_notify(net, req->hr_proto, flags);
+		if (ret)
+			clear_bit(class, &hn->hn_notified);
+	} else {
+		atomic_long_inc(&hn->hn_coalesced);
+		if (!genl_has_listeners(&handshake_nl_family, net, class)) {
+			clear_bit(class, &hn->hn_notified);
+			ret = -ESRCH;
+		}
+	}
 	if (ret) {
 		trace_handshake_notify_err(net, req, req->hr_sk, ret);
 		if (remove_pending(hn, req))
@@ -324,7 +399,11 @@ bool handshake_req_cancel(struct sock *sk)
 
 	hn = handshake_pernet(net);
 	if (hn && remove_pending(hn, req)) {
-		/* Request hadn't been accepted */
+		/* Request hadn't been accepted. The agent may never have
+		 * acted on the READY notification that covered it, so let
+		 * the next submission send a fresh one.
+		 */
+		clear_bit(req->hr_proto->hp_handler_class, &hn->hn_notified);
 		goto out_true;
 	}
 	if (test_and_set_bit(HANDSHAKE_F_REQ_COMPLETED, &req->hr_flags)) {
@@ -38,6 +38,7 @@
 #include <linux/in.h>
 #include <linux/ip.h>
 #include <linux/udp.h>
+#include <linux/etherdevice.h>
 #include <linux/l2tp.h>
 #include <linux/sort.h>
 #include <linux/file.h>
@@ -45,7 +46,9 @@
 #include <net/net_namespace.h>
 #include <net/netns/generic.h>
 #include <net/dst.h>
+#include <net/gro.h>
 #include <net/ip.h>
+#include <net/ip_tunnels.h>
 #include <net/udp.h>
 #include <net/udp_tunnel.h>
 #include <net/inet_common.h>
@@ -656,15 +659,16 @@ static void l2tp_recv_dequeue_skb(struct l2tp_session *session, struct sk_buff *
 {
 	struct l2tp_tunnel *tunnel = session->tunnel;
 	int length = L2TP_SKB_CB(skb)->length;
+	unsigned int segs = skb_is_gso(skb) ? skb_shinfo(skb)->gso_segs : 1;
 
 	/* We're about to requeue the skb, so return resources
 	 * to its current owner (a socket receive buffer).
 	 */
 	skb_orphan(skb);
 
-	atomic_long_inc(&tunnel->stats.rx_packets);
+	atomic_long_add(segs, &tunnel->stats.rx_packets);
 	atomic_long_add(length, &tunnel->stats.rx_bytes);
-	atomic_long_inc(&session->stats.rx_packets);
+	atomic_long_add(segs, &session->stats.rx_packets);
 	atomic_long_add(length, &session->stats.rx_bytes);
 
 	if (L2TP_SKB_CB(skb)->has_seq) {
@@ -980,6 +984,13 @@ void l2tp_recv_common(struct l2tp_session *session, struct sk_buff *skb,
 	if (L2TP_SKB_CB(skb)->has_seq) {
 		if (l2tp_recv_data_seq(session, skb))
 			goto discard;
+	} else if (skb_queue_empty_lockless(&session->reorder_q)) {
+		/* No sequence numbers and nothing held for reordering, so
+		 * there is nothing this skb could overtake. Deliver it
+		 * directly rather than bouncing it through reorder_q.
+		 */
+		l2tp_recv_dequeue_skb(session, skb);
+		return;
 	} else {
 		/* No sequence numbers. Add the skb to the tail of the
 		 * reorder queue. This ensures that it will be
@@ -1089,6 +1100,14 @@ int l2tp_udp_encap_recv(struct sock *sk, struct sk_buff *skb)
 	if (version != tunnel->version)
 		goto invalid;
 
+	/* Aggregated by l2tp_udp_gro_receive() */
+	if (skb_is_gso(skb) && iptunnel_pull_offloads(skb)) {
+		atomic_long_inc(&session->stats.rx_errors);
+		l2tp_session_put(session);
+		kfree_skb(skb);
+		return 0;
+	}
+
 	if (version == L2TP_HDR_VER_3 &&
 	    l2tp_v3_ensure_opt_in_linear(session, skb, &ptr, &optr)) {
 		l2tp_session_put(session);
@@ -1104,6 +1123,15 @@ int l2tp_udp_encap_recv(struct sock *sk, struct sk_buff *skb)
 	atomic_long_inc(&tunnel->stats.rx_invalid);
 
 pass:
+	/* GRO only aggregates packets of sessions that were found above.
+	 * If the session went away in between, the skb can't be handed
+	 * to userspace as a single datagram.
+	 */
+	if (unlikely(skb_is_gso(skb))) {
+		kfree_skb(skb);
+		return 0;
+	}
+
 	/* Put UDP header back */
 	__skb_push(skb, sizeof(struct udphdr));
 
@@ -1111,6 +1139,103 @@ int l2tp_udp_encap_recv(struct sock *sk, struct sk_buff *skb)
 }
 EXPORT_SYMBOL_GPL(l2tp_udp_encap_recv);
 
+/* Find the session an L2TPv3 data packet received on sk belongs to, if it
+ * is one whose packets GRO may aggregate: an ethernet pseudowire that is
+ * not subject to a session ID collision. Called under RCU, no reference is
+ * taken.
+ */
+static struct l2tp_session *l2tp_udp_gro_session(struct sock *sk,
+						 const __be32 *l2h)
+{
+	const struct l2tp_net *pn = l2tp_pernet(sock_net(sk));
+	struct l2tp_session *session;
+	struct l2tp_tunnel *tunnel;
+	u16 hdrflags;
+
+	hdrflags = ntohs(*(__be16 *)l2h);
+	if ((hdrflags & L2TP_HDR_VER_MASK) != L2TP_HDR_VER_3 ||
+	    (hdrflags & L2TP_HDRFLAG_T))
+		return NULL;
+
+	session = idr_find(&pn->l2tp_v3_session_idr, ntohl(l2h[1]));
+	if (!session || hash_hashed(&session->hlist) ||
+	    session->pwtype != L2TP_PWTYPE_ETH)
+		return NULL;
+
+	tunnel = READ_ONCE(session->tunnel);
+	if (!tunnel || tunnel->sock != sk)
+		return NULL;
+
+	return session;
+}
+
+/* L2TPv3 header length as seen on receive: flags, session ID, cookie and
+ * L2-specific sublayer.
+ */
+static unsigned int l2tp_udp_gro_hlen(struct l2tp_session *session)
+{
+	return 8 + session->peer_cookie_len + l2tp_get_l2specific_len(session);
+}
+
+static struct sk_buff *l2tp_udp_gro_receive(struct sock *sk,
+					    struct list_head *head,
+					    struct sk_buff *skb)
+{
+	struct l2tp_session *session;
+	struct sk_buff *pp = NULL;
+	unsigned int off, hlen;
+	struct sk_buff *p;
+	__be32 *l2h;
+	int flush = 1;
+
+	off = skb_gro_offset(skb);
+	l2h = skb_gro_header(skb, off + 8, off);
+	if (!l2h)
+		goto out;
+
+	session = l2tp_udp_gro_session(sk, l2h);
+	if (!session)
+		goto out;
+
+	hlen = l2tp_udp_gro_hlen(session);
+	l2h = skb_gro_header(skb, off + hlen, off);
+	if (!l2h)
+		goto out;
+
+	/* The whole header, including the cookie and any sequence number
+	 * in the sublayer, must match for packets to be merged.
+	 */
+	list_for_each_entry(p, head, list) {
+		if (!NAPI_GRO_CB(p)->same_flow)
+			continue;
+
+		if (memcmp(l2h, p->data + off, hlen))
+			NAPI_GRO_CB(p)->same_flow = 0;
+	}
+
+	skb_gro_pull(skb, hlen);
+	skb_gro_postpull_rcsum(skb, l2h, hlen);
+	pp = call_gro_receive(eth_gro_receive, head, skb);
+	flush = 0;
+
+out:
+	skb_gro_flush_final(skb, pp, flush);
+
+	return pp;
+}
+
+static int l2tp_udp_gro_complete(struct sock *sk, struct sk_buff *skb,
+				 int nhoff)
+{
+	struct l2tp_session *session;
+
+	session = l2tp_udp_gro_session(sk, (__be32 *)(skb->data + nhoff));
+	if (!session)
+		return -ENOENT;
+
+	return eth_gro_complete(skb, nhoff + l2tp_udp_gro_hlen(session));
+}
+
 /* UDP encapsulation receive error handler. See net/ipv4/udp.c for details. */
 static void l2tp_udp_encap_err_recv(struct sock *sk, struct sk_buff *skb, int err,
 				    __be16 port, u32 info, u8 *payload)
@@ -1674,6 +1799,8 @@ int l2tp_tunnel_register(struct l2tp_tunnel *tunnel, struct net *net,
 			.encap_rcv = l2tp_udp_encap_recv,
 			.encap_err_rcv = l2tp_udp_encap_err_recv,
 			.encap_destroy = l2tp_udp_encap_destroy,
+			.gro_receive = l2tp_udp_gro_receive,
+			.gro_complete = l2tp_udp_gro_complete,
 		};
 
 		setup_udp_tunnel_sock(net, sock, &udp_cfg);
@@ -112,8 +112,11 @@ static void l2tp_eth_dev_recv(struct l2tp_session *session, struct sk_buff *skb,
 
 	secpath_reset(skb);
 
-	/* checksums verified by L2TP */
-	skb->ip_summed = CHECKSUM_NONE;
+	/* checksums verified by L2TP. An skb aggregated by GRO keeps
+	 * the checksum state GRO set up for the merged inner packets.
+	 */
+	if (!skb_is_gso(skb))
+		skb->ip_summed = CHECKSUM_NONE;
 
 	/* drop outer flow-hash */
 	skb_clear_hash(skb);
@@ -212,8 +212,11 @@ enum ieee80211_rx_flags {
 	IEEE80211_RX_BEACON_REPORTED	= BIT(1),
 };
 
+struct ieee80211_rx_batch;
+
 struct ieee80211_rx_data {
 	struct list_head *list;
+	struct ieee80211_rx_batch *batch;
 	struct sk_buff *skb;
 	struct ieee80211_local *local;
 	struct ieee80211_sub_if_data *sdata;
@@ -1350,7 +1350,11 @@ static bool ieee80211_sta_manage_reorder_buf(struct ieee80211_sub_if_data *sdata
  * Reorder MPDUs from A-MPDUs, keeping them on a buffer. Returns
  * true if the MPDU was buffered, false if it should be processed.
  */
-static void ieee80211_rx_reorder_ampdu(struct ieee80211_rx_data *rx,
+/*
+ * Returns true if the frame belongs to a BA session, i.e. it went through
+ * the reorder buffer and whatever that released is in @frames.
+ */
+static bool ieee80211_rx_reorder_ampdu(struct ieee80211_rx_data *rx,
 				       struct sk_buff_head *frames)
 {
 	struct sk_buff *skb = rx->skb;
@@ -1405,7 +1409,7 @@ static void ieee80211_rx_reorder_ampdu(struct ieee80211_rx_data *rx,
 	sc = le16_to_cpu(hdr->seq_ctrl);
 	if (sc & IEEE80211_SCTL_FRAG) {
 		ieee80211_queue_skb_to_iface(rx->sdata, rx->link_id, NULL, skb);
-		return;
+		return true;
 	}
 
 	/*
@@ -1415,12 +1419,14 @@ static void ieee80211_rx_reorder_ampdu(struct ieee80211_rx_data *rx,
 	 * sure that we cannot get to it any more before doing
 	 * anything with it.
 	 */
-	if (ieee80211_sta_manage_reorder_buf(rx->sdata, tid_agg_rx, skb,
-					     frames))
-		return;
+	if (!ieee80211_sta_manage_reorder_buf(rx->sdata, tid_agg_rx, skb,
+					      frames))
+		__skb_queue_tail(frames, skb);
+	return true;
 
  dont_reorder:
 	__skb_queue_tail(frames, skb);
+	return false;
 }
 
 static ieee80211_rx_result debug_noinline
@@ -4235,10 +4241,61 @@ static void ieee80211_rx_handlers(struct ieee80211_rx_data *rx,
 	spin_unlock_bh(&rx->local->rx_path_lock);
 }
 
+/*
+ * Frames handed to ieee80211_rx_list_batch() that need the full RX handler
+ * chain and are not part of a BA session are not run through it one by
+ * one. They are collected here, and consecutive frames for the same
+ * station, link and TID go through the handlers as one list.
+ */
+struct ieee80211_rx_batch {
+	struct ieee80211_rx_data rx;
+	struct sk_buff_head frames;
+};
+
+static void ieee80211_rx_batch_flush(struct ieee80211_rx_batch *batch)
+{
+	if (!batch || skb_queue_empty(&batch->frames))
+		return;
+
+	ieee80211_rx_handlers(&batch->rx, &batch->frames);
+}
+
+static bool ieee80211_rx_batch_match(struct ieee80211_rx_batch *batch,
+				     struct ieee80211_rx_data *rx)
+{
+	struct ieee80211_rx_data *prev = &batch->rx;
+
+	return prev->sdata == rx->sdata && prev->sta == rx->sta &&
+	       prev->link == rx->link && prev->link_sta == rx->link_sta &&
+	       prev->list == rx->list && prev->flags == rx->flags &&
+	       prev->seqno_idx == rx->seqno_idx &&
+	       prev->security_idx == rx->security_idx;
+}
+
+static void ieee80211_rx_batch_add(struct ieee80211_rx_data *rx,
+				   struct sk_buff_head *frames)
+{
+	struct ieee80211_rx_batch *batch = rx->batch;
+
+	if (skb_queue_empty(frames))
+		return;
+
+	if (!skb_queue_empty(&batch->frames) &&
+	    !ieee80211_rx_batch_match(batch, rx))
+		ieee80211_rx_batch_flush(batch);
+
+	if (skb_queue_empty(&batch->frames)) {
+		batch->rx = *rx;
+		batch->rx.batch = NULL;
+	}
+	skb_queue_splice_tail_init(frames, &batch->frames);
+}
+
 static void ieee80211_invoke_rx_handlers(struct ieee80211_rx_data *rx)
 {
 	struct sk_buff_head reorder_release;
 	ieee80211_rx_result res = RX_DROP_MONITOR;
+	bool reordered;
 
 	__skb_queue_head_init(&reorder_release);
 
@@ -4252,8 +4309,18 @@ static void ieee80211_invoke_rx_handlers(struct ieee80211_rx_data *rx)
 	CALL_RXH(ieee80211_rx_h_check_dup);
 	CALL_RXH(ieee80211_rx_h_check);
 
-	ieee80211_rx_reorder_ampdu(rx, &reorder_release);
+	reordered = ieee80211_rx_reorder_ampdu(rx, &reorder_release);
 
+	/* What the reorder buffer releases must reach the handlers before
+	 * the reorder timer can release later frames of the same TID, so
+	 * frames of a BA session are never held back in a batch.
+	 */
+	if (rx->batch && !reordered) {
+		ieee80211_rx_batch_add(rx, &reorder_release);
+		return;
+	}
+
+	ieee80211_rx_batch_flush(rx->batch);
 	ieee80211_rx_handlers(rx, &reorder_release);
 	return;
 
@@ -5054,6 +5121,9 @@ static bool ieee80211_prepare_and_rx_handle(struct ieee80211_rx_data *rx,
 	if (consume && rx->sta) {
 		struct ieee80211_fast_rx *fast_rx;
 
+		/* fast-rx delivers right away, keep the frame order */
+		ieee80211_rx_batch_flush(rx->batch);
+
 		fast_rx = rcu_dereference(rx->sta->fast_rx);
 		if (fast_rx && ieee80211_invoke_fast_rx(rx, fast_rx))
 			return true;
@@ -5199,7 +5269,8 @@ static bool ieee80211_rx_for_interface(struct ieee80211_rx_data *rx,
 static void __ieee80211_rx_handle_packet(struct ieee80211_hw *hw,
 					 struct ieee80211_sta *pubsta,
 					 struct sk_buff *skb,
-					 struct list_head *list)
+					 struct list_head *list,
+					 struct ieee80211_rx_batch *batch)
 {
 	struct ieee80211_local *local = hw_to_local(hw);
 	struct ieee80211_rx_status *status = IEEE80211_SKB_RXCB(skb);
@@ -5216,6 +5287,7 @@ static void __ieee80211_rx_handle_packet(struct ieee80211_hw *hw,
 	rx.skb = skb;
 	rx.local = local;
 	rx.list = list;
+	rx.batch = batch;
 	rx.link_id = -1;
 
 	if (ieee80211_is_data(fc) || ieee80211_is_mgmt(fc))
@@ -5353,12 +5425,10 @@ static void __ieee80211_rx_handle_packet(struct ieee80211_hw *hw,
 	dev_kfree_skb(skb);
 }
 
-/*
- * This is the receive path handler. It is called by a low level driver when an
- * 802.11 MPDU is received from the hardware.
- */
-void ieee80211_rx_list(struct ieee80211_hw *hw, struct ieee80211_sta *pubsta,
-		       struct sk_buff *skb, struct list_head *list)
+static void __ieee80211_rx_list(struct ieee80211_hw *hw,
+				struct ieee80211_sta *pubsta,
+				struct sk_buff *skb, struct list_head *list,
+				struct ieee80211_rx_batch *batch)
 {
 	struct ieee80211_local *local = hw_to_local(hw);
 	struct ieee80211_rate *rate = NULL;
@@ -5477,10 +5547,13 @@ void ieee80211_rx_list(struct ieee80211_hw *hw, struct ieee80211_sta *pubsta,
 			ieee80211_is_data_present(hdr->frame_control))
 			ieee80211_tpt_led_trig_rx(local, skb->len);
 
-		if (status->flag & RX_FLAG_8023)
+		if (status->flag & RX_FLAG_8023) {
+			ieee80211_rx_batch_flush(batch);
 			__ieee80211_rx_handle_8023(hw, pubsta, skb, list);
-		else
-			__ieee80211_rx_handle_packet(hw, pubsta, skb, list);
+		} else {
+			__ieee80211_rx_handle_packet(hw, pubsta, skb, list,
+						     batch);
+		}
 	}
 
 	kcov_remote_stop();
@@ -5488,8 +5561,35 @@ void ieee80211_rx_list(struct ieee80211_hw *hw, struct ieee80211_sta *pubsta,
  drop:
 	kfree_skb(skb);
 }
+
+/*
+ * This is the receive path handler. It is called by a low level driver when an
+ * 802.11 MPDU is received from the hardware.
+ */
+void ieee80211_rx_list(struct ieee80211_hw *hw, struct ieee80211_sta *pubsta,
+		       struct sk_buff *skb, struct list_head *list)
+{
+	__ieee80211_rx_list(hw, pubsta, skb, list, NULL);
+}
 EXPORT_SYMBOL(ieee80211_rx_list);
 
+void ieee80211_rx_list_batch(struct ieee80211_hw *hw,
+			     struct ieee80211_sta *pubsta,
+			     struct sk_buff_head *skbs,
+			     struct list_head *list)
+{
+	struct ieee80211_rx_batch batch;
+	struct sk_buff *skb;
+
+	__skb_queue_head_init(&batch.frames);
+
+	while ((skb = __skb_dequeue(skbs)))
+		__ieee80211_rx_list(hw, pubsta, skb, list, &batch);
+
+	ieee80211_rx_batch_flush(&batch);
+}
+EXPORT_SYMBOL(ieee80211_rx_list_batch);
+
 void ieee80211_rx_napi(struct ieee80211_hw *hw, struct ieee80211_sta *pubsta,
 		       struct sk_buff *skb, struct napi_struct *napi)
 {
@@ -3803,29 +3803,13 @@ static bool ieee80211_xmit_fast(struct ieee80211_sub_if_data *sdata,
 	return true;
 }
 
-struct sk_buff *ieee80211_tx_dequeue(struct ieee80211_hw *hw,
-				     struct ieee80211_txq *txq)
+static bool ieee80211_txq_stopped(struct ieee80211_local *local,
+				  struct txq_info *txqi)
 {
-	struct ieee80211_local *local = hw_to_local(hw);
-	struct txq_info *txqi = container_of(txq, struct txq_info, txq);
-	struct ieee80211_hdr *hdr;
-	struct sk_buff *skb = NULL;
-	struct fq *fq = &local->fq;
-	struct fq_tin *tin = &txqi->tin;
-	struct ieee80211_tx_info *info;
-	struct ieee80211_tx_data tx;
-	ieee80211_tx_result r;
-	struct ieee80211_vif *vif = txq->vif;
-	int q = vif->hw_queue[txq->ac];
+	int q = txqi->txq.vif->hw_queue[txqi->txq.ac];
 	unsigned long flags;
 	bool q_stopped;
 
-	WARN_ON_ONCE(softirq_count() == 0);
-
-	if (!ieee80211_txq_airtime_check(hw, txq))
-		return NULL;
-
-begin:
 	spin_lock_irqsave(&local->queue_stop_reason_lock, flags);
 	q_stopped = local->queue_stop_reasons[q];
 	spin_unlock_irqrestore(&local->queue_stop_reason_lock, flags);
@@ -3833,30 +3817,64 @@ struct sk_buff *ieee80211_tx_dequeue(struct ieee80211_hw *hw,
 	if (unlikely(q_stopped)) {
 		/* mark for waking later */
 		set_bit(IEEE80211_TXQ_DIRTY, &txqi->flags);
-		return NULL;
+		return true;
 	}
 
-	spin_lock_bh(&fq->lock);
+	return false;
+}
+
+/* Take the next frame off a TXQ, with fq->lock held. Frames that still
+ * need the TX handlers are marked with IEEE80211_TX_INTCFL_NEED_TXPROCESSING
+ * for ieee80211_tx_dequeue_process().
+ */
+static struct sk_buff *ieee80211_txq_pull(struct fq *fq,
+					  struct txq_info *txqi)
+{
+	struct sk_buff *skb;
+
+	lockdep_assert_held(&fq->lock);
 
 	/* Make sure fragments stay together. */
 	skb = __skb_dequeue(&txqi->frags);
-	if (unlikely(skb)) {
-		if (!(IEEE80211_SKB_CB(skb)->control.flags &
-				IEEE80211_TX_INTCFL_NEED_TXPROCESSING))
-			goto out;
-		IEEE80211_SKB_CB(skb)->control.flags &=
-			~IEEE80211_TX_INTCFL_NEED_TXPROCESSING;
-	} else {
-		if (unlikely(test_bit(IEEE80211_TXQ_STOP, &txqi->flags)))
-			goto out;
+	if (unlikely(skb))
+		return skb;
 
-		skb = fq_tin_dequeue(fq, tin, fq_tin_dequeue_func);
-	}
+	if (unlikely(test_bit(IEEE80211_TXQ_STOP, &txqi->flags)))
+		return NULL;
 
-	if (!skb)
-		goto out;
+	skb = fq_tin_dequeue(fq, &txqi->tin, fq_tin_dequeue_func);
+	if (skb)
+		IEEE80211_SKB_CB(skb)->control.flags |=
+			IEEE80211_TX_INTCFL_NEED_TXPROCESSING;
 
-	spin_unlock_bh(&fq->lock);
+	return skb;
+}
+
+/* Run the late TX handlers on a frame taken off a TXQ. Returns the frame
+ * to hand to the driver, or NULL if it was dropped. If the frame is
+ * fragmented, the remaining fragments and then the frames in @rest, the
+ * rest of the caller's batch, are put back on the TXQ so they go out in
+ * order.
+ */
+static struct sk_buff *ieee80211_tx_dequeue_process(struct ieee80211_hw *hw,
+						    struct ieee80211_txq *txq,
+						    struct sk_buff *skb,
+						    struct sk_buff_head *rest)
+{
+	struct ieee80211_local *local = hw_to_local(hw);
+	struct txq_info *txqi = container_of(txq, struct txq_info, txq);
+	struct ieee80211_hdr *hdr;
+	struct fq *fq = &local->fq;
+	struct ieee80211_tx_info *info;
+	struct ieee80211_tx_data tx;
+	ieee80211_tx_result r;
+	struct ieee80211_vif *vif = txq->vif;
+
+	if (!(IEEE80211_SKB_CB(skb)->control.flags &
+	      IEEE80211_TX_INTCFL_NEED_TXPROCESSING))
+		return skb;
+	IEEE80211_SKB_CB(skb)->control.flags &=
+		~IEEE80211_TX_INTCFL_NEED_TXPROCESSING;
 
 	hdr = (struct ieee80211_hdr *)skb->data;
 	info = IEEE80211_SKB_CB(skb);
@@ -3885,7 +3903,7 @@ struct sk_buff *ieee80211_tx_dequeue(struct ieee80211_hw *hw,
 						     NULL)))) {
 			I802_DEBUG_INC(local->tx_handlers_drop_unauth_port);
 			ieee80211_free_txskb(&local->hw, skb);
-			goto begin;
+			return NULL;
 		}
 	}
 
@@ -3896,7 +3914,7 @@ struct sk_buff *ieee80211_tx_dequeue(struct ieee80211_hw *hw,
 	r = ieee80211_tx_h_select_key(&tx);
 	if (r != TX_CONTINUE) {
 		ieee80211_free_txskb(&local->hw, skb);
-		goto begin;
+		return NULL;
 	}
 
 	if (test_bit(IEEE80211_TXQ_AMPDU, &txqi->flags))
@@ -3908,7 +3926,7 @@ struct sk_buff *ieee80211_tx_dequeue(struct ieee80211_hw *hw,
 			r = ieee80211_tx_h_rate_ctrl(&tx);
 			if (r != TX_CONTINUE) {
 				ieee80211_free_txskb(&local->hw, skb);
-				goto begin;
+				return NULL;
 			}
 		}
 		goto encap_out;
@@ -3927,18 +3945,20 @@ struct sk_buff *ieee80211_tx_dequeue(struct ieee80211_hw *hw,
 					       tx.key, &tx);
 		if (r != TX_CONTINUE) {
 			ieee80211_free_txskb(&local->hw, skb);
-			goto begin;
+			return NULL;
 		}
 	} else {
 		if (invoke_tx_handlers_late(&tx))
-			goto begin;
+			return NULL;
 
 		skb = __skb_dequeue(&tx.skbs);
 		info = IEEE80211_SKB_CB(skb);
 
 		if (!skb_queue_empty(&tx.skbs)) {
 			spin_lock_bh(&fq->lock);
-			skb_queue_splice_tail(&tx.skbs, &txqi->frags);
+			if (rest)
+				skb_queue_splice_init(rest, &txqi->frags);
+			skb_queue_splice(&tx.skbs, &txqi->frags);
 			spin_unlock_bh(&fq->lock);
 		}
 	}
@@ -3947,7 +3967,7 @@ struct sk_buff *ieee80211_tx_dequeue(struct ieee80211_hw *hw,
 	    !ieee80211_hw_check(&local->hw, TX_FRAG_LIST)) {
 		if (skb_linearize(skb)) {
 			ieee80211_free_txskb(&local->hw, skb);
-			goto begin;
+			return NULL;
 		}
 	}
 
@@ -3966,7 +3986,7 @@ struct sk_buff *ieee80211_tx_dequeue(struct ieee80211_hw *hw,
 				vif->hw_queue[skb_get_queue_mapping(skb)];
 		} else if (ieee80211_hw_check(&local->hw, QUEUE_CONTROL)) {
 			ieee80211_free_txskb(&local->hw, skb);
-			goto begin;
+			return NULL;
 		} else {
 			info->control.vif = NULL;
 			return skb;
@@ -4001,14 +4021,118 @@ struct sk_buff *ieee80211_tx_dequeue(struct ieee80211_hw *hw,
 	}
 
 	return skb;
+}
 
-out:
-	spin_unlock_bh(&fq->lock);
+static struct sk_buff *__ieee80211_tx_dequeue(struct ieee80211_hw *hw,
+					      struct ieee80211_txq *txq)
+{
+	struct ieee80211_local *local = hw_to_local(hw);
+	struct txq_info *txqi = container_of(txq, struct txq_info, txq);
+	struct fq *fq = &local->fq;
+	struct sk_buff *skb;
+
+	do {
+		if (ieee80211_txq_stopped(local, txqi))
+			return NULL;
+
+		spin_lock_bh(&fq->lock);
+		skb = ieee80211_txq_pull(fq, txqi);
+		spin_unlock_bh(&fq->lock);
+
+		if (!skb)
+			return NULL;
+
+		skb = ieee80211_tx_dequeue_process(hw, txq, skb, NULL);
+	} while (!skb);
 
 	return skb;
 }
+
+struct sk_buff *ieee80211_tx_dequeue(struct ieee80211_hw *hw,
+				     struct ieee80211_txq *txq)
+{
+	WARN_ON_ONCE(softirq_count() == 0);
+
+	if (!ieee80211_txq_airtime_check(hw, txq))
+		return NULL;
+
+	return __ieee80211_tx_dequeue(hw, txq);
+}
 EXPORT_SYMBOL(ieee80211_tx_dequeue);
 
+int ieee80211_tx_dequeue_bulk(struct ieee80211_hw *hw,
+			      struct ieee80211_txq *txq,
+			      struct sk_buff_head *skbs, int budget)
+{
+	struct ieee80211_local *local = hw_to_local(hw);
+	struct txq_info *txqi = container_of(txq, struct txq_info, txq);
+	struct fq *fq = &local->fq;
+	struct sk_buff_head batch;
+	struct sk_buff *skb;
+	int n = 0;
+
+	WARN_ON_ONCE(softirq_count() == 0);
+
+	__skb_queue_head_init(&batch);
+
+	while (n < budget) {
+		if (!ieee80211_txq_airtime_check(hw, txq) ||
+		    ieee80211_txq_stopped(local, txqi))
+			break;
+
+		/* take what is still missing from the budget in one go */
+		spin_lock_bh(&fq->lock);
+		while (skb_queue_len(&batch) < budget - n &&
+		       (skb = ieee80211_txq_pull(fq, txqi)))
+			__skb_queue_tail(&batch, skb);
+		spin_unlock_bh(&fq->lock);
+
+		if (skb_queue_empty(&batch))
+			break;
+
+		while ((skb = __skb_dequeue(&batch)) != NULL) {
+			skb = ieee80211_tx_dequeue_process(hw, txq, skb,
+							   &batch);
+			if (skb) {
+				__skb_queue_tail(skbs, skb);
+				n++;
+			}
+
+			if (skb_queue_empty(&batch))
+				break;
+
+			/* the queue can be stopped and the airtime used up
+			 * while the batch is processed, put the rest back
+			 */
+			if (!ieee80211_txq_airtime_check(hw, txq) ||
+			    ieee80211_txq_stopped(local, txqi)) {
+				spin_lock_bh(&fq->lock);
+				skb_queue_splice_init(&batch, &txqi->frags);
+				spin_unlock_bh(&fq->lock);
+				return n;
+			}
+		}
+	}
+
+	return n;
+}
+EXPORT_SYMBOL(ieee80211_tx_dequeue_bulk);
+
+void ieee80211_tx_requeue_bulk(struct ieee80211_hw *hw,
+			       struct ieee80211_txq *txq,
+			       struct sk_buff_head *skbs)
+{
+	struct ieee80211_local *local = hw_to_local(hw);
+	struct txq_info *txqi = container_of(txq, struct txq_info, txq);
+	struct fq *fq = &local->fq;
+
+	/* already processed, so they go out as they are, like fragments */
+	spin_lock_bh(&fq->lock);
+	skb_queue_splice_init(skbs, &txqi->frags);
+	spin_unlock_bh(&fq->lock);
+}
+EXPORT_SYMBOL(ieee80211_tx_requeue_bulk);
+
 static inline s32 ieee80211_sta_deficit(struct sta_info *sta, u8 ac)
 {
 	struct airtime_info *air_info = &sta->airtime[ac];
@@ -1382,12 +1382,6 @@ static int mptcp_sendmsg_frag(struct sock *sk, struct sock *ssk,
 	return copy;
 }
 
-#define MPTCP_SEND_BURST_SIZE		((1 << 16) - \
-					 sizeof(struct tcphdr) - \
-					 MAX_TCP_OPTION_SPACE - \
-					 sizeof(struct ipv6hdr) - \
-					 sizeof(struct frag_hdr))
-
 struct subflow_send_info {
 	struct sock *ssk;
 	u64 linger_time;
@@ -1486,7 +1480,7 @@ struct sock *mptcp_subflow_get_send(struct mptcp_sock *msk)
 	if (!ssk || !sk_stream_memory_free(ssk))
 		return NULL;
 
-	burst = min_t(int, MPTCP_SEND_BURST_SIZE, mptcp_wnd_end(msk) - msk->snd_nxt);
+	burst = mptcp_sched_send_burst(msk, MPTCP_SEND_BURST_SIZE);
 	wmem = READ_ONCE(ssk->sk_wmem_queued);
 	if (!burst)
 		return ssk;
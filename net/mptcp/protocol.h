@@ -335,6 +335,8 @@ struct mptcp_sock {
 				 */
 	struct mptcp_pm_data	pm;
 	struct mptcp_sched_ops	*sched;
+#define MPTCP_SCHED_PRIV_SIZE	(2 * sizeof(u64))
+	u64		sched_priv[MPTCP_SCHED_PRIV_SIZE / sizeof(u64)];
 	struct {
 		u32	space;	/* bytes copied in last measurement window */
 		u32	copied; /* bytes copied in this measurement window */
@@ -754,6 +756,26 @@ struct sock *mptcp_subflow_get_send(struct mptcp_sock *msk);
 struct sock *mptcp_subflow_get_retrans(struct mptcp_sock *msk);
 int mptcp_sched_get_send(struct mptcp_sock *msk);
 int mptcp_sched_get_retrans(struct mptcp_sock *msk);
+int mptcp_sched_set_by_name(struct mptcp_sock *msk, const char *name);
+
+#define MPTCP_SEND_BURST_SIZE		((1 << 16) - \
+					 sizeof(struct tcphdr) - \
+					 MAX_TCP_OPTION_SPACE - \
+					 sizeof(struct ipv6hdr) - \
+					 sizeof(struct frag_hdr))
+
+/* amount of data the scheduler can push on the selected subflow before
+ * asking again, bounded by the peer's receive window
+ */
+static inline int mptcp_sched_send_burst(const struct mptcp_sock *msk, int limit)
+{
+	return min_t(int, limit, READ_ONCE(msk->wnd_end) - msk->snd_nxt);
+}
+
+static inline void *mptcp_sched_priv(const struct mptcp_sock *msk)
+{
+	return (void *)msk->sched_priv;
+}
 
 static inline u64 mptcp_data_avail(const struct mptcp_sock *msk)
 {
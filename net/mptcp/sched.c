@@ -36,6 +36,207 @@ static struct mptcp_sched_ops mptcp_sched_default = {
 	.owner		= THIS_MODULE,
 };
 
+static bool mptcp_sched_subflow_usable(struct mptcp_subflow_context *subflow)
+{
+	return mptcp_subflow_active(subflow) &&
+	       sk_stream_memory_free(mptcp_subflow_tcp_sock(subflow));
+}
+
+static bool mptcp_sched_subflow_backup(const struct mptcp_subflow_context *subflow)
+{
+	return subflow->backup || subflow->request_bkup;
+}
+
+/* backup subflows are only eligible when no other subflow can be used */
+static bool mptcp_sched_use_backup(struct mptcp_sock *msk)
+{
+	struct mptcp_subflow_context *subflow;
+
+	mptcp_for_each_subflow(msk, subflow) {
+		if (!mptcp_sched_subflow_backup(subflow) &&
+		    mptcp_subflow_active(subflow))
+			return false;
+	}
+	return true;
+}
+
+static bool mptcp_sched_cwnd_avail(const struct sock *ssk)
+{
+	const struct tcp_sock *tp = tcp_sk(ssk);
+
+	return tcp_packets_in_flight(tp) < tcp_snd_cwnd(tp);
+}
+
+/* Lowest RTT first: send on the usable subflow with the smallest smoothed
+ * RTT that still has congestion window space, falling back to the lowest
+ * RTT one overall when all of them are cwnd limited.
+ */
+static struct sock *mptcp_sched_lowrtt_pick(struct mptcp_sock *msk)
+{
+	u32 best_rtt = U32_MAX, best_cwnd_rtt = U32_MAX;
+	struct sock *best = NULL, *best_cwnd = NULL;
+	struct mptcp_subflow_context *subflow;
+	bool backup;
+
+	backup = mptcp_sched_use_backup(msk);
+	mptcp_for_each_subflow(msk, subflow) {
+		struct sock *ssk = mptcp_subflow_tcp_sock(subflow);
+		u32 srtt;
+
+		if (mptcp_sched_subflow_backup(subflow) != backup ||
+		    !mptcp_sched_subflow_usable(subflow))
+			continue;
+
+		/* srtt_us is 0 until the first sample, prefer measured paths */
+		srtt = tcp_sk(ssk)->srtt_us ? : U32_MAX - 1;
+		if (srtt < best_rtt) {
+			best_rtt = srtt;
+			best = ssk;
+		}
+		if (srtt < best_cwnd_rtt && mptcp_sched_cwnd_avail(ssk)) {
+			best_cwnd_rtt = srtt;
+			best_cwnd = ssk;
+		}
+	}
+
+	return best_cwnd ? : best;
+}
+
+static int mptcp_sched_lowrtt_get_subflow(struct mptcp_sock *msk,
+					  struct mptcp_sched_data *data)
+{
+	struct sock *ssk;
+
+	if (data->reinject)
+		return mptcp_sched_default_get_subflow(msk, data);
+
+	ssk = mptcp_sched_lowrtt_pick(msk);
+	if (!ssk)
+		return -EINVAL;
+
+	msk->snd_burst = mptcp_sched_send_burst(msk, MPTCP_SEND_BURST_SIZE);
+	mptcp_subflow_set_scheduled(mptcp_subflow_ctx(ssk), true);
+	return 0;
+}
+
+static struct mptcp_sched_ops mptcp_sched_lowrtt = {
+	.get_subflow	= mptcp_sched_lowrtt_get_subflow,
+	.name		= "lowrtt",
+	.owner		= THIS_MODULE,
+};
+
+/* Redundant: new data goes to the lowest RTT subflow, while every
+ * retransmission is scheduled on all the usable subflows at once, so that
+ * a loss or a stall on a single path never delays the data.
+ */
+static int mptcp_sched_red_get_subflow(struct mptcp_sock *msk,
+				       struct mptcp_sched_data *data)
+{
+	struct mptcp_subflow_context *subflow;
+	bool backup, found = false;
+
+	if (!data->reinject)
+		return mptcp_sched_lowrtt_get_subflow(msk, data);
+
+	/* still let the default retrans logic kick the stale subflows */
+	if (!mptcp_subflow_get_retrans(msk))
+		return -EINVAL;
+
+	backup = mptcp_sched_use_backup(msk);
+	mptcp_for_each_subflow(msk, subflow) {
+		if (mptcp_sched_subflow_backup(subflow) != backup ||
+		    !mptcp_sched_subflow_usable(subflow))
+			continue;
+
+		mptcp_subflow_set_scheduled(subflow, true);
+		found = true;
+	}
+
+	return found ? 0 : -EINVAL;
+}
+
+static struct mptcp_sched_ops mptcp_sched_red = {
+	.get_subflow	= mptcp_sched_red_get_subflow,
+	.name		= "redundant",
+	.owner		= THIS_MODULE,
+};
+
+/* Weighted round-robin: the subflows take turns, each one pushing up to a
+ * full congestion window worth of data, so that the share of the traffic
+ * carried by each path follows its capacity.
+ */
+struct mptcp_sched_wrr {
+	u32	last_id;
+};
+
+static int mptcp_sched_wrr_quota(const struct sock *ssk)
+{
+	const struct tcp_sock *tp = tcp_sk(ssk);
+
+	return max_t(int, tcp_snd_cwnd(tp) * tp->mss_cache, tp->mss_cache);
+}
+
+static int mptcp_sched_wrr_get_subflow(struct mptcp_sock *msk,
+				       struct mptcp_sched_data *data)
+{
+	struct mptcp_sched_wrr *wrr = mptcp_sched_priv(msk);
+	struct mptcp_subflow_context *subflow, *first = NULL, *next = NULL;
+	bool backup, after_last = false;
+
+	if (data->reinject)
+		return mptcp_sched_default_get_subflow(msk, data);
+
+	backup = mptcp_sched_use_backup(msk);
+	mptcp_for_each_subflow(msk, subflow) {
+		if (mptcp_sched_subflow_backup(subflow) != backup ||
+		    !mptcp_sched_subflow_usable(subflow)) {
+			if (subflow->subflow_id == wrr->last_id)
+				after_last = true;
+			continue;
+		}
+
+		/* the current subflow is also the fallback when it is the only
+		 * usable one: its quota is then refilled below
+		 */
+		if (!first)
+			first = subflow;
+
+		/* keep on using the current subflow until its quota is over */
+		if (subflow->subflow_id == wrr->last_id) {
+			if (msk->snd_burst > 0) {
+				next = subflow;
+				break;
+			}
+			after_last = true;
+			continue;
+		}
+
+		if (after_last) {
+			next = subflow;
+			break;
+		}
+	}
+
+	if (!next)
+		next = first;
+	if (!next)
+		return -EINVAL;
+
+	if (next->subflow_id != wrr->last_id || msk->snd_burst <= 0) {
+		wrr->last_id = next->subflow_id;
+		msk->snd_burst = mptcp_sched_wrr_quota(mptcp_subflow_tcp_sock(next));
+	}
+	msk->snd_burst = mptcp_sched_send_burst(msk, msk->snd_burst);
+	mptcp_subflow_set_scheduled(next, true);
+	return 0;
+}
+
+static struct mptcp_sched_ops mptcp_sched_wrr = {
+	.get_subflow	= mptcp_sched_wrr_get_subflow,
+	.name		= "wrr",
+	.owner		= THIS_MODULE,
+};
+
 /* Must be called with rcu read lock held */
 struct mptcp_sched_ops *mptcp_sched_find(const char *name)
 {
@@ -100,7 +301,12 @@ void mptcp_unregister_scheduler(struct mptcp_sched_ops *sched)
 
 void mptcp_sched_init(void)
 {
+	BUILD_BUG_ON(sizeof(struct mptcp_sched_wrr) > MPTCP_SCHED_PRIV_SIZE);
+
 	mptcp_register_scheduler(&mptcp_sched_default);
+	mptcp_register_scheduler(&mptcp_sched_lowrtt);
+	mptcp_register_scheduler(&mptcp_sched_red);
+	mptcp_register_scheduler(&mptcp_sched_wrr);
 }
 
 int mptcp_init_sched(struct mptcp_sock *msk,
@@ -112,6 +318,7 @@ int mptcp_init_sched(struct mptcp_sock *msk,
 	if (!bpf_try_module_get(sched, sched->owner))
 		return -EBUSY;
 
+	memset(msk->sched_priv, 0, sizeof(msk->sched_priv));
 	msk->sched = sched;
 	if (msk->sched->init)
 		msk->sched->init(msk);
@@ -135,6 +342,46 @@ void mptcp_release_sched(struct mptcp_sock *msk)
 	bpf_module_put(sched, sched->owner);
 }
 
+/* switch the msk to the scheduler called @name, must be called with the
+ * msk socket lock held
+ */
+int mptcp_sched_set_by_name(struct mptcp_sock *msk, const char *name)
+{
+	struct mptcp_sched_ops *sched;
+	int ret;
+
+	msk_owned_by_me(msk);
+
+	rcu_read_lock();
+	sched = mptcp_sched_find(name);
+	if (!sched) {
+		ret = -ENOENT;
+		goto unlock;
+	}
+
+	if (sched == msk->sched) {
+		ret = 0;
+		goto unlock;
+	}
+
+	if (!bpf_try_module_get(sched, sched->owner)) {
+		ret = -EBUSY;
+		goto unlock;
+	}
+	rcu_read_unlock();
+
+	mptcp_release_sched(msk);
+	ret = mptcp_init_sched(msk, sched);
+
+	/* mptcp_init_sched() took its own reference */
+	bpf_module_put(sched, sched->owner);
+	return ret;
+
+unlock:
+	rcu_read_unlock();
+	return ret;
+}
+
 void mptcp_subflow_set_scheduled(struct mptcp_subflow_context *subflow,
 				 bool scheduled)
 {
@@ -867,6 +867,32 @@ static int mptcp_setsockopt_sol_tcp(struct mptcp_sock *msk, int optname,
 	return ret;
 }
 
+static int mptcp_setsockopt_sol_mptcp(struct mptcp_sock *msk, int optname,
+				      sockptr_t optval, unsigned int optlen)
+{
+	struct sock *sk = (struct sock *)msk;
+	char name[MPTCP_SCHED_NAME_MAX];
+	int ret;
+
+	if (optname != MPTCP_SCHEDULER)
+		return -ENOPROTOOPT;
+
+	if (optlen < 1)
+		return -EINVAL;
+
+	ret = strncpy_from_sockptr(name, optval,
+				   min_t(long, MPTCP_SCHED_NAME_MAX - 1, optlen));
+	if (ret < 0)
+		return -EFAULT;
+
+	name[ret] = 0;
+
+	lock_sock(sk);
+	ret = mptcp_sched_set_by_name(msk, name);
+	release_sock(sk);
+	return ret;
+}
+
 int mptcp_setsockopt(struct sock *sk, int level, int optname,
 		     sockptr_t optval, unsigned int optlen)
 {
@@ -878,6 +904,9 @@ int mptcp_setsockopt(struct sock *sk, int level, int optname,
 	if (level == SOL_SOCKET)
 		return mptcp_setsockopt_sol_socket(msk, optname, optval, optlen);
 
+	if (level == SOL_MPTCP)
+		return mptcp_setsockopt_sol_mptcp(msk, optname, optval, optlen);
+
 	if (!mptcp_supported_sockopt(level, optname))
 		return -ENOPROTOOPT;
 
@@ -1430,6 +1459,32 @@ static int mptcp_getsockopt_v4(struct mptcp_sock *msk, int optname,
 	return -EOPNOTSUPP;
 }
 
+static int mptcp_getsockopt_scheduler(struct mptcp_sock *msk, char __user *optval,
+				      int __user *optlen)
+{
+	char name[MPTCP_SCHED_NAME_MAX] = {};
+	struct sock *sk = (struct sock *)msk;
+	int len;
+
+	if (get_user(len, optlen))
+		return -EFAULT;
+
+	if (len < 0)
+		return -EINVAL;
+
+	lock_sock(sk);
+	if (msk->sched)
+		strscpy(name, msk->sched->name, sizeof(name));
+	release_sock(sk);
+
+	len = min_t(unsigned int, len, sizeof(name));
+	if (put_user(len, optlen))
+		return -EFAULT;
+	if (copy_to_user(optval, name, len))
+		return -EFAULT;
+	return 0;
+}
+
 static int mptcp_getsockopt_sol_mptcp(struct mptcp_sock *msk, int optname,
 				      char __user *optval, int __user *optlen)
 {
@@ -1442,6 +1497,8 @@ static int mptcp_getsockopt_sol_mptcp(struct mptcp_sock *msk, int optname,
 		return mptcp_getsockopt_tcpinfo(msk, optval, optlen);
 	case MPTCP_SUBFLOW_ADDRS:
 		return mptcp_getsockopt_subflow_addrs(msk, optval, optlen);
+	case MPTCP_SCHEDULER:
+		return mptcp_getsockopt_scheduler(msk, optval, optlen);
 	}
 
 	return -EOPNOTSUPP;
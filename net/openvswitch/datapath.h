@@ -39,7 +39,8 @@
  *   @n_mask_hit / (@n_hit + @n_missed)  will be the average masks looked
  *   up per packet.
  * @n_cache_hit: The number of received packets that had their mask found using
- * the mask cache.
+ * the mask cache, or their flow found using the exact match cache.  An exact
+ * match cache hit accounts for a single mask lookup in @n_mask_hit.
  */
 struct dp_stats_percpu {
 	u64 n_hit;
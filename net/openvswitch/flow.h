@@ -231,6 +231,10 @@ struct sw_flow {
 	struct sw_flow_id id;
 	struct cpumask *cpu_used_mask;
 	struct sw_flow_mask *mask;
+	bool dead;			/* Removed from the flow table, stale
+					 * exact match cache entries must
+					 * not use it.
+					 */
 	struct sw_flow_actions __rcu *sf_acts;
 	struct sw_flow_stats __rcu *stats[]; /* One for each CPU.  First one
 					   * is allocated at flow creation time,
@@ -42,7 +42,14 @@
 #define MC_HASH_SHIFT		8
 #define MC_HASH_SEGS		((sizeof(uint32_t) * 8) / MC_HASH_SHIFT)
 
+#define EMC_ENTRIES		1024
+
 static struct kmem_cache *flow_cache;
+
+/* Generation of the exact match caches of all tables, zeroed cache
+ * entries must never look valid.
+ */
+static atomic64_t emc_gen = ATOMIC64_INIT(1);
 struct kmem_cache *flow_stats_cache __read_mostly;
 
 static u16 range_n_bytes(const struct sw_flow_key_range *range)
@@ -132,13 +139,30 @@ static void rcu_free_flow_callback(struct rcu_head *rcu)
 	flow_free(flow);
 }
 
+/* A removed flow may still be referenced by exact match cache entries,
+ * all of them stored by readers that are done by now.  Move the cache
+ * generation past theirs and free the flow once the readers that may
+ * still use such an entry are gone as well.  Flows retired in the same
+ * grace period all see the same generation, so it is bumped only once
+ * for all of them.
+ */
+static void rcu_retire_flow_callback(struct rcu_head *rcu)
+{
+	struct sw_flow *flow = container_of(rcu, struct sw_flow, rcu);
+	s64 gen = atomic64_read(&emc_gen);
+
+	atomic64_cmpxchg(&emc_gen, gen, gen + 1);
+	call_rcu(&flow->rcu, rcu_free_flow_callback);
+}
+
 void ovs_flow_free(struct sw_flow *flow, bool deferred)
 {
 	if (!flow)
 		return;
 
 	if (deferred)
-		call_rcu(&flow->rcu, rcu_free_flow_callback);
+		call_rcu(&flow->rcu, flow->dead ? rcu_retire_flow_callback :
+						  rcu_free_flow_callback);
 	else
 		flow_free(flow);
 }
@@ -430,6 +454,12 @@ int ovs_flow_tbl_init(struct flow_table *table)
 	if (!ufid_ti)
 		goto free_ti;
 
+	table->emc = __alloc_percpu(array_size(sizeof(struct flow_emc_entry),
+					       EMC_ENTRIES),
+				    __alignof__(struct flow_emc_entry));
+	if (!table->emc)
+		goto free_ufid_ti;
+
 	rcu_assign_pointer(table->ti, ti);
 	rcu_assign_pointer(table->ufid_ti, ufid_ti);
 	rcu_assign_pointer(table->mask_array, ma);
@@ -439,6 +469,8 @@ int ovs_flow_tbl_init(struct flow_table *table)
 	table->ufid_count = 0;
 	return 0;
 
+free_ufid_ti:
+	__table_instance_destroy(ufid_ti);
 free_ti:
 	__table_instance_destroy(ti);
 free_mask_array:
@@ -464,6 +496,11 @@ static void table_instance_flow_free(struct flow_table *table,
 	hlist_del_rcu(&flow->flow_table.node[ti->node_ver]);
 	table->count--;
 
+	/* Exact match cache hits skip the flow from now on, the cache
+	 * generation is retired before it is freed.
+	 */
+	WRITE_ONCE(flow->dead, true);
+
 	if (ovs_identifier_is_ufid(&flow->id)) {
 		hlist_del_rcu(&flow->ufid_table.node[ufid_ti->node_ver]);
 		table->ufid_count--;
@@ -517,6 +554,7 @@ void ovs_flow_tbl_destroy(struct flow_table *table)
 	struct mask_cache *mc = rcu_dereference_raw(table->mask_cache);
 	struct mask_array *ma = rcu_dereference_raw(table->mask_array);
 
+	free_percpu(table->emc);
 	call_rcu(&mc->rcu, mask_cache_rcu_cb);
 	call_rcu(&ma->rcu, mask_array_rcu_cb);
 	table_instance_destroy(ti, ufid_ti);
@@ -773,6 +811,58 @@ static struct sw_flow *flow_lookup(struct flow_table *tbl,
 	return NULL;
 }
 
+/* Exact match cache lookup: a hit costs a single masked key compare
+ * against the cached flow, no hashing and no bucket walk.  The usage
+ * counter of the flow's mask is bumped as flow_lookup() would, so the
+ * mask rebalancing still sees the traffic served from here.  Must be
+ * called with BH disabled.
+ */
+static struct sw_flow *emc_lookup(struct flow_table *tbl,
+				  struct mask_array *ma,
+				  const struct sw_flow_key *key,
+				  u32 skb_hash, u64 gen)
+{
+	struct mask_array_stats *stats;
+	struct flow_emc_entry *e;
+	struct sw_flow_key masked_key;
+	struct sw_flow *flow;
+
+	e = this_cpu_ptr(tbl->emc) + (skb_hash & (EMC_ENTRIES - 1));
+	if (e->skb_hash != skb_hash || e->gen != gen)
+		return NULL;
+
+	flow = e->flow;
+	if (READ_ONCE(flow->dead))
+		return NULL;
+
+	/* The mask array was reordered or replaced since the insert. */
+	if (e->mask_index >= ma->max ||
+	    rcu_dereference_ovsl(ma->masks[e->mask_index]) != flow->mask)
+		return NULL;
+
+	ovs_flow_mask_key(&masked_key, key, false, flow->mask);
+	if (!flow_cmp_masked_key(flow, &masked_key, &flow->mask->range))
+		return NULL;
+
+	stats = this_cpu_ptr(ma->masks_usage_stats);
+	u64_stats_update_begin(&stats->syncp);
+	stats->usage_cntrs[e->mask_index]++;
+	u64_stats_update_end(&stats->syncp);
+	return flow;
+}
+
+static void emc_insert(struct flow_table *tbl, struct sw_flow *flow,
+		       u32 skb_hash, u32 mask_index, u64 gen)
+{
+	struct flow_emc_entry *e;
+
+	e = this_cpu_ptr(tbl->emc) + (skb_hash & (EMC_ENTRIES - 1));
+	e->skb_hash = skb_hash;
+	e->mask_index = mask_index;
+	e->gen = gen;
+	e->flow = flow;
+}
+
 /*
  * mask_cache maps flow to probable mask. This cache is not tightly
  * coupled cache, It means updates to  mask list can result in inconsistent
@@ -792,6 +882,7 @@ struct sw_flow *ovs_flow_tbl_lookup_stats(struct flow_table *tbl,
 	struct mask_cache_entry *entries, *ce;
 	struct sw_flow *flow;
 	u32 hash;
+	u64 gen;
 	int seg;
 
 	*n_mask_hit = 0;
@@ -810,6 +901,17 @@ struct sw_flow *ovs_flow_tbl_lookup_stats(struct flow_table *tbl,
 	if (key->recirc_id)
 		skb_hash = jhash_1word(skb_hash, key->recirc_id);
 
+	/* Sample the generation before any lookup, so that a flow removed
+	 * while we are looking it up is never cached as valid.
+	 */
+	gen = atomic64_read(&emc_gen);
+	flow = emc_lookup(tbl, ma, key, skb_hash, gen);
+	if (flow) {
+		(*n_mask_hit)++;
+		(*n_cache_hit)++;
+		return flow;
+	}
+
 	ce = NULL;
 	hash = skb_hash;
 	entries = this_cpu_ptr(mc->mask_cache);
@@ -823,7 +925,10 @@ struct sw_flow *ovs_flow_tbl_lookup_stats(struct flow_table *tbl,
 		if (e->skb_hash == skb_hash) {
 			flow = flow_lookup(tbl, ti, ma, key, n_mask_hit,
 					   n_cache_hit, &e->mask_index);
-			if (!flow)
+			if (flow)
+				emc_insert(tbl, flow, skb_hash,
+					   e->mask_index, gen);
+			else
 				e->skb_hash = 0;
 			return flow;
 		}
@@ -837,8 +942,10 @@ struct sw_flow *ovs_flow_tbl_lookup_stats(struct flow_table *tbl,
 	/* Cache miss, do full lookup. */
 	flow = flow_lookup(tbl, ti, ma, key, n_mask_hit, n_cache_hit,
 			   &ce->mask_index);
-	if (flow)
+	if (flow) {
 		ce->skb_hash = skb_hash;
+		emc_insert(tbl, flow, skb_hash, ce->mask_index, gen);
+	}
 
 	*n_cache_hit = 0;
 	return flow;
@@ -1215,6 +1322,10 @@ int ovs_flow_init(void)
 /* Uninitializes the flow module. */
 void ovs_flow_exit(void)
 {
+	/* Removed flows are requeued once by rcu_retire_flow_callback(),
+	 * wait for those as well.
+	 */
+	rcu_barrier();
 	kmem_cache_destroy(flow_stats_cache);
 	kmem_cache_destroy(flow_cache);
 }
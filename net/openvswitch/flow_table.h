@@ -33,6 +33,20 @@ struct mask_cache {
 	struct mask_cache_entry __percpu *mask_cache;
 };
 
+/* Per-CPU exact match cache, mapping the skb hash straight to the last
+ * matching flow and the index of its mask.  Entries of removed flows are
+ * skipped on lookup, and are only trusted while @gen matches the cache
+ * generation, which is bumped before removed flows are freed.  The
+ * generation is 64 bits wide so that it never wraps back onto a stale
+ * entry.
+ */
+struct flow_emc_entry {
+	u64 gen;
+	u32 skb_hash;
+	u32 mask_index;
+	struct sw_flow *flow;
+};
+
 struct mask_count {
 	int index;
 	u64 counter;
@@ -64,6 +78,7 @@ struct flow_table {
 	struct table_instance __rcu *ufid_ti;
 	struct mask_cache __rcu *mask_cache;
 	struct mask_array __rcu *mask_array;
+	struct flow_emc_entry __percpu *emc;
 	unsigned long last_rehash;
 	unsigned int count;
 	unsigned int ufid_count;
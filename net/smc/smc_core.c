@@ -47,6 +47,8 @@ struct smc_lgr_list smc_lgr_list = {	/* established link groups */
 };
 
 static atomic_t lgr_cnt = ATOMIC_INIT(0); /* number of existing link groups */
+/* bytes parked in the per-CPU buffer caches of all link groups */
+static atomic_long_t smc_buf_cache_bytes = ATOMIC_LONG_INIT(0);
 static DECLARE_WAIT_QUEUE_HEAD(lgrs_deleted);
 
 static void smc_buf_free(struct smc_link_group *lgr, bool is_rmb,
@@ -902,6 +904,11 @@ static int smc_lgr_create(struct smc_sock *smc, struct smc_init_info *ini)
 		rc = -ENOMEM;
 		goto free_lgr;
 	}
+	lgr->buf_cache = alloc_percpu(struct smc_buf_cache);
+	if (!lgr->buf_cache) {
+		rc = -ENOMEM;
+		goto free_wq;
+	}
 	lgr->is_smcd = ini->is_smcd;
 	lgr->sync_err = 0;
 	lgr->terminating = 0;
@@ -986,6 +993,7 @@ static int smc_lgr_create(struct smc_sock *smc, struct smc_init_info *ini)
 	return 0;
 
 free_wq:
+	free_percpu(lgr->buf_cache);
 	destroy_workqueue(lgr->tx_wq);
 free_lgr:
 	kfree(lgr);
@@ -1156,12 +1164,94 @@ struct smc_link *smc_switch_conns(struct smc_link_group *lgr,
 	return NULL;
 }
 
+static struct smc_buf_desc **smc_buf_cache_slot(struct smc_link_group *lgr,
+						bool is_rmb, int bufsize_comp)
+{
+	/* the slot is only a hint for locality, so being migrated after
+	 * picking it is harmless; all accesses to it are atomic
+	 */
+	struct smc_buf_cache *cache = raw_cpu_ptr(lgr->buf_cache);
+
+	return is_rmb ? &cache->rmbs[bufsize_comp] :
+			&cache->sndbufs[bufsize_comp];
+}
+
+/* park a buffer that is no longer used by its connection in this CPU's
+ * cache instead of returning it to the link group lists. The buffer stays
+ * marked as used and registered, so the next connection of the same size
+ * class on this CPU takes it over without touching the list locks. The
+ * memory held this way by all link groups together is capped at
+ * SMC_BUF_CACHE_MAX_BYTES, beyond that buffers go back to the lists.
+ */
+static bool smc_buf_cache_put(struct smc_link_group *lgr, bool is_rmb,
+			      struct smc_buf_desc *buf_desc, int len)
+{
+	struct smc_buf_desc **slot;
+
+	slot = smc_buf_cache_slot(lgr, is_rmb, buf_desc->bufsize_comp);
+	if (READ_ONCE(*slot))
+		return false;
+	if (atomic_long_add_return(buf_desc->len, &smc_buf_cache_bytes) >
+	    SMC_BUF_CACHE_MAX_BYTES)
+		goto uncharge;
+	/* the buffer is handed out as soon as it is in the slot */
+	memzero_explicit(buf_desc->cpu_addr, len);
+	if (!cmpxchg(slot, NULL, buf_desc))
+		return true;
+uncharge:
+	atomic_long_sub(buf_desc->len, &smc_buf_cache_bytes);
+	return false;
+}
+
+static struct smc_buf_desc *smc_buf_cache_get(struct smc_link_group *lgr,
+					      bool is_rmb, int bufsize_comp)
+{
+	struct smc_buf_desc **slot, *buf_desc;
+
+	slot = smc_buf_cache_slot(lgr, is_rmb, bufsize_comp);
+	if (!READ_ONCE(*slot))
+		return NULL;
+	buf_desc = xchg(slot, NULL);
+	if (buf_desc)
+		atomic_long_sub(buf_desc->len, &smc_buf_cache_bytes);
+	return buf_desc;
+}
+
+/* empty the caches of a link group that is going away, its buffers are
+ * freed from the link group lists
+ */
+static void smc_buf_cache_drain(struct smc_link_group *lgr)
+{
+	struct smc_buf_desc *buf_desc;
+	struct smc_buf_cache *cache;
+	int cpu, i;
+
+	for_each_possible_cpu(cpu) {
+		cache = per_cpu_ptr(lgr->buf_cache, cpu);
+		for (i = 0; i < SMC_RMBE_SIZES; i++) {
+			buf_desc = xchg(&cache->sndbufs[i], NULL);
+			if (buf_desc)
+				atomic_long_sub(buf_desc->len,
+						&smc_buf_cache_bytes);
+			buf_desc = xchg(&cache->rmbs[i], NULL);
+			if (buf_desc)
+				atomic_long_sub(buf_desc->len,
+						&smc_buf_cache_bytes);
+		}
+	}
+}
+
 static void smcr_buf_unuse(struct smc_buf_desc *buf_desc, bool is_rmb,
 			   struct smc_link_group *lgr)
 {
 	struct rw_semaphore *lock;	/* lock buffer list */
 	int rc;
 
+	/* a cached rmb keeps its rkey confirmed with the peer */
+	if (!buf_desc->is_reg_err &&
+	    smc_buf_cache_put(lgr, is_rmb, buf_desc, buf_desc->len))
+		return;
+
 	if (is_rmb && buf_desc->is_conf_rkey && !list_empty(&lgr->list)) {
 		/* unregister rmb with peer */
 		rc = smc_llc_flow_initiate(lgr, SMC_LLC_FLOW_RKEY);
@@ -1216,7 +1306,8 @@ static void smc_buf_unuse(struct smc_connection *conn,
 		bufsize = conn->sndbuf_desc->len;
 		if (!is_smcd && conn->sndbuf_desc->is_vm) {
 			smcr_buf_unuse(conn->sndbuf_desc, false, lgr);
-		} else {
+		} else if (!smc_buf_cache_put(lgr, false, conn->sndbuf_desc,
+					      bufsize)) {
 			memzero_explicit(conn->sndbuf_desc->cpu_addr, bufsize);
 			WRITE_ONCE(conn->sndbuf_desc->used, 0);
 		}
@@ -1228,8 +1319,12 @@ static void smc_buf_unuse(struct smc_connection *conn,
 			smcr_buf_unuse(conn->rmb_desc, true, lgr);
 		} else {
 			bufsize += sizeof(struct smcd_cdc_msg);
-			memzero_explicit(conn->rmb_desc->cpu_addr, bufsize);
-			WRITE_ONCE(conn->rmb_desc->used, 0);
+			if (!smc_buf_cache_put(lgr, true, conn->rmb_desc,
+					       bufsize)) {
+				memzero_explicit(conn->rmb_desc->cpu_addr,
+						 bufsize);
+				WRITE_ONCE(conn->rmb_desc->used, 0);
+			}
 		}
 		SMC_STAT_RMB_SIZE(smc, is_smcd, true, false, bufsize);
 	}
@@ -1444,7 +1539,9 @@ static void smc_lgr_free_bufs(struct smc_link_group *lgr)
 /* won't be freed until no one accesses to lgr anymore */
 static void __smc_lgr_free(struct smc_link_group *lgr)
 {
+	smc_buf_cache_drain(lgr);
 	smc_lgr_free_bufs(lgr);
+	free_percpu(lgr->buf_cache);
 	if (lgr->is_smcd) {
 		if (!atomic_dec_return(&lgr->smcd->lgr_cnt))
 			wake_up(&lgr->smcd->lgrs_deleted);
@@ -2441,8 +2538,17 @@ static int __smc_buf_create(struct smc_sock *smc, bool is_smcd, bool is_rmb)
 		}
 		bufsize = smc_uncompress_bufsize(bufsize_comp);
 
-		/* check for reusable slot in the link group */
-		buf_desc = smc_buf_get_slot(bufsize_comp, lock, buf_list);
+		/* check for a buffer cached on this cpu, then for a
+		 * reusable slot in the link group
+		 */
+		buf_desc = smc_buf_cache_get(lgr, is_rmb, bufsize_comp);
+		if (buf_desc) {
+			SMC_STAT_BUF_CACHE_HIT(smc, is_smcd, is_rmb);
+		} else {
+			SMC_STAT_BUF_CACHE_MISS(smc, is_smcd, is_rmb);
+			buf_desc = smc_buf_get_slot(bufsize_comp, lock,
+						    buf_list);
+		}
 		if (buf_desc) {
 			buf_desc->is_dma_need_sync = 0;
 			SMC_STAT_RMB_SIZE(smc, is_smcd, is_rmb, true, bufsize);
@@ -2468,6 +2574,7 @@ static int __smc_buf_create(struct smc_sock *smc, bool is_smcd, bool is_rmb)
 		SMC_STAT_RMB_ALLOC(smc, is_smcd, is_rmb);
 		SMC_STAT_RMB_SIZE(smc, is_smcd, is_rmb, true, bufsize);
 		buf_desc->used = 1;
+		buf_desc->bufsize_comp = bufsize_comp;
 		down_write(lock);
 		smc_lgr_buf_list_add(lgr, is_rmb, buf_list, buf_desc);
 		up_write(lock);
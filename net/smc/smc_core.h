@@ -196,6 +196,7 @@ struct smc_buf_desc {
 	struct page		*pages;
 	int			len;		/* length of buffer */
 	u32			used;		/* currently used / unused */
+	u8			bufsize_comp;	/* index into lgr buffer lists */
 	union {
 		struct { /* SMC-R */
 			struct sg_table	sgt[SMC_LINKS_PER_LGR_MAX];
@@ -243,6 +244,16 @@ struct smc_rtoken {				/* address/key of remote RMB */
  * struct smc_clc_msg_accept_confirm.rmbe_size being a 4 bit value (0..15)
  */
 
+#define SMC_BUF_CACHE_MAX_BYTES	(64UL << 20)	/* over all link groups */
+
+/* one spare buffer per size class and CPU, parked by a finished connection
+ * for the next one created on that CPU; cached buffers stay marked as used
+ */
+struct smc_buf_cache {
+	struct smc_buf_desc	*sndbufs[SMC_RMBE_SIZES];
+	struct smc_buf_desc	*rmbs[SMC_RMBE_SIZES];
+};
+
 struct smcd_dev;
 
 enum smc_lgr_type {				/* redundancy state of lgr */
@@ -285,6 +296,8 @@ struct smc_link_group {
 	struct rw_semaphore	sndbufs_lock;	/* protects tx buffers */
 	struct list_head	rmbs[SMC_RMBE_SIZES];	/* rx buffers */
 	struct rw_semaphore	rmbs_lock;	/* protects rx buffers */
+	struct smc_buf_cache __percpu *buf_cache;
+						/* per-CPU spare buffers */
 	u64			alloc_sndbufs;	/* stats of tx buffers */
 	u64			alloc_rmbs;	/* stats of rx buffers */
 
@@ -51,6 +51,20 @@ static int smc_lo_query_rgid(struct smcd_dev *smcd, struct smcd_gid *rgid,
 	return 0;
 }
 
+/* Must be called under rcu_read_lock() or with dmb_ht_lock held */
+static struct smc_lo_dmb_node *smc_lo_find_dmb(struct smc_lo_dev *ldev,
+					       u64 token)
+{
+	struct smc_lo_dmb_node *tmp_node;
+
+	hash_for_each_possible_rcu(ldev->dmb_ht, tmp_node, list, token,
+				   lockdep_is_held(&ldev->dmb_ht_lock)) {
+		if (tmp_node->token == token)
+			return tmp_node;
+	}
+	return NULL;
+}
+
 static int smc_lo_register_dmb(struct smcd_dev *smcd, struct smcd_dmb *dmb,
 			       void *client_priv)
 {
@@ -87,15 +101,15 @@ static int smc_lo_register_dmb(struct smcd_dev *smcd, struct smcd_dmb *dmb,
 again:
 	/* add new dmb into hash table */
 	get_random_bytes(&dmb_node->token, sizeof(dmb_node->token));
-	write_lock_bh(&ldev->dmb_ht_lock);
+	spin_lock_bh(&ldev->dmb_ht_lock);
 	hash_for_each_possible(ldev->dmb_ht, tmp_node, list, dmb_node->token) {
 		if (tmp_node->token == dmb_node->token) {
-			write_unlock_bh(&ldev->dmb_ht_lock);
+			spin_unlock_bh(&ldev->dmb_ht_lock);
 			goto again;
 		}
 	}
-	hash_add(ldev->dmb_ht, &dmb_node->list, dmb_node->token);
-	write_unlock_bh(&ldev->dmb_ht_lock);
+	hash_add_rcu(ldev->dmb_ht, &dmb_node->list, dmb_node->token);
+	spin_unlock_bh(&ldev->dmb_ht_lock);
 	atomic_inc(&ldev->dmb_cnt);
 
 	dmb->sba_idx = dmb_node->sba_idx;
@@ -113,17 +127,25 @@ static int smc_lo_register_dmb(struct smcd_dev *smcd, struct smcd_dmb *dmb,
 	return rc;
 }
 
+static void smc_lo_free_dmb_rcu(struct rcu_head *head)
+{
+	struct smc_lo_dmb_node *dmb_node =
+		container_of(head, struct smc_lo_dmb_node, rcu);
+
+	kvfree(dmb_node->cpu_addr);
+	kfree(dmb_node);
+}
+
 static void __smc_lo_unregister_dmb(struct smc_lo_dev *ldev,
 				    struct smc_lo_dmb_node *dmb_node)
 {
 	/* remove dmb from hash table */
-	write_lock_bh(&ldev->dmb_ht_lock);
-	hash_del(&dmb_node->list);
-	write_unlock_bh(&ldev->dmb_ht_lock);
+	spin_lock_bh(&ldev->dmb_ht_lock);
+	hash_del_rcu(&dmb_node->list);
+	spin_unlock_bh(&ldev->dmb_ht_lock);
 
 	clear_bit(dmb_node->sba_idx, ldev->sba_idx_mask);
-	kvfree(dmb_node->cpu_addr);
-	kfree(dmb_node);
+	call_rcu(&dmb_node->rcu, smc_lo_free_dmb_rcu);
 
 	if (atomic_dec_and_test(&ldev->dmb_cnt))
 		wake_up(&ldev->ldev_release);
@@ -131,22 +153,15 @@ static void __smc_lo_unregister_dmb(struct smc_lo_dev *ldev,
 
 static int smc_lo_unregister_dmb(struct smcd_dev *smcd, struct smcd_dmb *dmb)
 {
-	struct smc_lo_dmb_node *dmb_node = NULL, *tmp_node;
+	struct smc_lo_dmb_node *dmb_node;
 	struct smc_lo_dev *ldev = smcd->priv;
 
 	/* find dmb from hash table */
-	read_lock_bh(&ldev->dmb_ht_lock);
-	hash_for_each_possible(ldev->dmb_ht, tmp_node, list, dmb->dmb_tok) {
-		if (tmp_node->token == dmb->dmb_tok) {
-			dmb_node = tmp_node;
-			break;
-		}
-	}
-	if (!dmb_node) {
-		read_unlock_bh(&ldev->dmb_ht_lock);
+	rcu_read_lock();
+	dmb_node = smc_lo_find_dmb(ldev, dmb->dmb_tok);
+	rcu_read_unlock();
+	if (!dmb_node)
 		return -EINVAL;
-	}
-	read_unlock_bh(&ldev->dmb_ht_lock);
 
 	if (refcount_dec_and_test(&dmb_node->refcnt))
 		__smc_lo_unregister_dmb(ldev, dmb_node);
@@ -160,28 +175,20 @@ static int smc_lo_support_dmb_nocopy(struct smcd_dev *smcd)
 
 static int smc_lo_attach_dmb(struct smcd_dev *smcd, struct smcd_dmb *dmb)
 {
-	struct smc_lo_dmb_node *dmb_node = NULL, *tmp_node;
+	struct smc_lo_dmb_node *dmb_node;
 	struct smc_lo_dev *ldev = smcd->priv;
 
 	/* find dmb_node according to dmb->dmb_tok */
-	read_lock_bh(&ldev->dmb_ht_lock);
-	hash_for_each_possible(ldev->dmb_ht, tmp_node, list, dmb->dmb_tok) {
-		if (tmp_node->token == dmb->dmb_tok) {
-			dmb_node = tmp_node;
-			break;
-		}
-	}
-	if (!dmb_node) {
-		read_unlock_bh(&ldev->dmb_ht_lock);
-		return -EINVAL;
-	}
-	read_unlock_bh(&ldev->dmb_ht_lock);
-
-	if (!refcount_inc_not_zero(&dmb_node->refcnt))
+	rcu_read_lock();
+	dmb_node = smc_lo_find_dmb(ldev, dmb->dmb_tok);
+	if (!dmb_node || !refcount_inc_not_zero(&dmb_node->refcnt)) {
 		/* the dmb is being unregistered, but has
 		 * not been removed from the hash table.
 		 */
+		rcu_read_unlock();
 		return -EINVAL;
+	}
+	rcu_read_unlock();
 
 	/* provide dmb information */
 	dmb->sba_idx = dmb_node->sba_idx;
@@ -194,22 +201,15 @@ static int smc_lo_attach_dmb(struct smcd_dev *smcd, struct smcd_dmb *dmb)
 
 static int smc_lo_detach_dmb(struct smcd_dev *smcd, u64 token)
 {
-	struct smc_lo_dmb_node *dmb_node = NULL, *tmp_node;
+	struct smc_lo_dmb_node *dmb_node;
 	struct smc_lo_dev *ldev = smcd->priv;
 
 	/* find dmb_node according to dmb->dmb_tok */
-	read_lock_bh(&ldev->dmb_ht_lock);
-	hash_for_each_possible(ldev->dmb_ht, tmp_node, list, token) {
-		if (tmp_node->token == token) {
-			dmb_node = tmp_node;
-			break;
-		}
-	}
-	if (!dmb_node) {
-		read_unlock_bh(&ldev->dmb_ht_lock);
+	rcu_read_lock();
+	dmb_node = smc_lo_find_dmb(ldev, token);
+	rcu_read_unlock();
+	if (!dmb_node)
 		return -EINVAL;
-	}
-	read_unlock_bh(&ldev->dmb_ht_lock);
 
 	if (refcount_dec_and_test(&dmb_node->refcnt))
 		__smc_lo_unregister_dmb(ldev, dmb_node);
@@ -220,9 +220,10 @@ static int smc_lo_move_data(struct smcd_dev *smcd, u64 dmb_tok,
 			    unsigned int idx, bool sf, unsigned int offset,
 			    void *data, unsigned int size)
 {
-	struct smc_lo_dmb_node *rmb_node = NULL, *tmp_node;
 	struct smc_lo_dev *ldev = smcd->priv;
+	struct smc_lo_dmb_node *rmb_node;
 	struct smc_connection *conn;
+	int rc = 0;
 
 	if (!sf)
 		/* since sndbuf is merged with peer DMB, there is
@@ -230,25 +231,26 @@ static int smc_lo_move_data(struct smcd_dev *smcd, u64 dmb_tok,
 		 */
 		return 0;
 
-	read_lock_bh(&ldev->dmb_ht_lock);
-	hash_for_each_possible(ldev->dmb_ht, tmp_node, list, dmb_tok) {
-		if (tmp_node->token == dmb_tok) {
-			rmb_node = tmp_node;
-			break;
-		}
-	}
+	/* Only the CDC cursor update is left to do per message, so keep
+	 * it off the shared dmb_ht_lock.
+	 */
+	rcu_read_lock();
+	rmb_node = smc_lo_find_dmb(ldev, dmb_tok);
 	if (!rmb_node) {
-		read_unlock_bh(&ldev->dmb_ht_lock);
-		return -EINVAL;
+		rc = -EINVAL;
+		goto out;
 	}
 	memcpy((char *)rmb_node->cpu_addr + offset, data, size);
-	read_unlock_bh(&ldev->dmb_ht_lock);
 
-	conn = smcd->conn[rmb_node->sba_idx];
-	if (!conn || conn->killed)
-		return -EPIPE;
+	conn = READ_ONCE(smcd->conn[rmb_node->sba_idx]);
+	if (!conn || conn->killed) {
+		rc = -EPIPE;
+		goto out;
+	}
 	tasklet_schedule(&conn->rx_tsklet);
-	return 0;
+out:
+	rcu_read_unlock();
+	return rc;
 }
 
 static int smc_lo_supports_v2(void)
@@ -358,7 +360,7 @@ static void smcd_lo_unregister_dev(struct smc_lo_dev *ldev)
 static int smc_lo_dev_init(struct smc_lo_dev *ldev)
 {
 	smc_lo_generate_ids(ldev);
-	rwlock_init(&ldev->dmb_ht_lock);
+	spin_lock_init(&ldev->dmb_ht_lock);
 	hash_init(ldev->dmb_ht);
 	atomic_set(&ldev->dmb_cnt, 0);
 	init_waitqueue_head(&ldev->ldev_release);
@@ -30,6 +30,7 @@ struct smc_lo_dmb_node {
 	void *cpu_addr;
 	dma_addr_t dma_addr;
 	refcount_t refcnt;
+	struct rcu_head rcu;
 };
 
 struct smc_lo_dev {
@@ -38,7 +39,7 @@ struct smc_lo_dev {
 	u16 chid;
 	struct smcd_gid local_gid;
 	atomic_t dmb_cnt;
-	rwlock_t dmb_ht_lock;
+	spinlock_t dmb_ht_lock; /* protects dmb_ht updates */
 	DECLARE_BITMAP(sba_idx_mask, SMC_LO_MAX_DMBS);
 	DECLARE_HASHTABLE(dmb_ht, SMC_LO_DMBS_HASH_BITS);
 	wait_queue_head_t ldev_release;
@@ -85,6 +85,14 @@ static int smc_nl_fill_stats_rmb_data(struct sk_buff *skb,
 			      stats_rmb_cnt->dgrade_cnt,
 			      SMC_NLA_STATS_RMB_PAD))
 		goto errattr;
+	if (nla_put_u64_64bit(skb, SMC_NLA_STATS_RMB_CACHE_HIT_CNT,
+			      stats_rmb_cnt->cache_hit_cnt,
+			      SMC_NLA_STATS_RMB_PAD))
+		goto errattr;
+	if (nla_put_u64_64bit(skb, SMC_NLA_STATS_RMB_CACHE_MISS_CNT,
+			      stats_rmb_cnt->cache_miss_cnt,
+			      SMC_NLA_STATS_RMB_PAD))
+		goto errattr;
 
 	nla_nest_end(skb, attrs);
 	return 0;
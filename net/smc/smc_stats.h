@@ -54,6 +54,8 @@ struct smc_stats_rmbcnt {
 	u64	reuse_cnt;
 	u64	alloc_cnt;
 	u64	dgrade_cnt;
+	u64	cache_hit_cnt;
+	u64	cache_miss_cnt;
 };
 
 struct smc_stats_memsize {
@@ -206,6 +208,12 @@ while (0)
 #define SMC_STAT_RMB_DOWNGRADED(smc, is_smcd, is_rx) \
 	SMC_STAT_RMB(smc, dgrade, is_smcd, is_rx)
 
+#define SMC_STAT_BUF_CACHE_HIT(smc, is_smcd, is_rx) \
+	SMC_STAT_RMB(smc, cache_hit, is_smcd, is_rx)
+
+#define SMC_STAT_BUF_CACHE_MISS(smc, is_smcd, is_rx) \
+	SMC_STAT_RMB(smc, cache_miss, is_smcd, is_rx)
+
 #define SMC_STAT_RMB_TX_PEER_FULL(smc, is_smcd) \
 	SMC_STAT_RMB(smc, buf_full_peer, is_smcd, false)
 
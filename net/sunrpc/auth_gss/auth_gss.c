@@ -1810,12 +1810,17 @@ alloc_enc_pages(struct rpc_rqst *rqstp)
 	last = (snd_buf->page_base + snd_buf->page_len - 1) >> PAGE_SHIFT;
 	rqstp->rq_enc_pages_num = last - first + 1 + 1;
 	rqstp->rq_enc_pages
-		= kmalloc_array(rqstp->rq_enc_pages_num,
-				sizeof(struct page *),
-				GFP_KERNEL);
+		= kcalloc(rqstp->rq_enc_pages_num,
+			  sizeof(struct page *),
+			  GFP_KERNEL);
 	if (!rqstp->rq_enc_pages)
 		goto out;
-	for (i=0; i < rqstp->rq_enc_pages_num; i++) {
+	/* One trip to the page allocator for the whole send buffer. The bulk
+	 * allocator may stop short, fill whatever it left one by one.
+	 */
+	i = alloc_pages_bulk(GFP_KERNEL, rqstp->rq_enc_pages_num,
+			     rqstp->rq_enc_pages);
+	for (; i < rqstp->rq_enc_pages_num; i++) {
 		rqstp->rq_enc_pages[i] = alloc_page(GFP_KERNEL);
 		if (rqstp->rq_enc_pages[i] == NULL)
 			goto out_free;
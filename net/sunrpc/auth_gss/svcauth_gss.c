@@ -38,6 +38,7 @@
  *
  */
 
+#include <linux/bitmap.h>
 #include <linux/slab.h>
 #include <linux/types.h>
 #include <linux/module.h>
@@ -639,6 +640,18 @@ gss_svc_searchbyctx(struct cache_detail *cd, struct xdr_netobj *handle)
 	return found;
 }
 
+/* Mark @count sequence numbers starting at @seq_num as not yet seen */
+static void gss_seq_win_clear(struct gss_svc_seq_data *sd, u32 seq_num,
+			      u32 count)
+{
+	u32 idx = seq_num % GSS_SEQ_WIN;
+	u32 len = min(count, GSS_SEQ_WIN - idx);
+
+	bitmap_clear(sd->sd_win, idx, len);
+	if (count > len)
+		bitmap_clear(sd->sd_win, 0, count - len);
+}
+
 /**
  * gss_check_seq_num - GSS sequence number window check
  * @rqstp: RPC Call to use when reporting errors
@@ -660,13 +673,12 @@ static bool gss_check_seq_num(const struct svc_rqst *rqstp, struct rsc *rsci,
 
 	spin_lock(&sd->sd_lock);
 	if (seq_num > sd->sd_max) {
-		if (seq_num >= sd->sd_max + GSS_SEQ_WIN) {
+		if (seq_num >= sd->sd_max + GSS_SEQ_WIN)
 			memset(sd->sd_win, 0, sizeof(sd->sd_win));
-			sd->sd_max = seq_num;
-		} else while (sd->sd_max < seq_num) {
-			sd->sd_max++;
-			__clear_bit(sd->sd_max % GSS_SEQ_WIN, sd->sd_win);
-		}
+		else
+			gss_seq_win_clear(sd, sd->sd_max + 1,
+					  seq_num - sd->sd_max);
+		sd->sd_max = seq_num;
 		__set_bit(seq_num % GSS_SEQ_WIN, sd->sd_win);
 		goto ok;
 	} else if (seq_num + GSS_SEQ_WIN <= sd->sd_max) {
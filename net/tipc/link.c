@@ -48,6 +48,9 @@
 
 #include <linux/pkt_sched.h>
 
+/* Max time in usecs a small message may be held back for bundling, 0 = off */
+int sysctl_tipc_bundle_delay __read_mostly;
+
 struct tipc_stats {
 	u32 sent_pkts;
 	u32 recv_pkts;
@@ -176,6 +179,7 @@ struct tipc_link {
 		u16 limit;
 		struct sk_buff *target_bskb;
 	} backlog[5];
+	struct sk_buff *hold_bskb;
 	u16 snd_nxt;
 
 	/* Reception */
@@ -979,6 +983,8 @@ void tipc_link_reset(struct tipc_link *l)
 		l->backlog[imp].len = 0;
 		l->backlog[imp].target_bskb = NULL;
 	}
+	kfree_skb(l->hold_bskb);
+	l->hold_bskb = NULL;
 	kfree_skb(l->reasm_buf);
 	kfree_skb(l->reasm_tnlmsg);
 	kfree_skb(l->failover_reasm_skb);
@@ -1001,6 +1007,97 @@ void tipc_link_reset(struct tipc_link *l)
 	tipc_link_reset_stats(l);
 }
 
+/* tipc_link_hold(): hold back a small data message for time bounded bundling
+ *
+ * When a bundle delay is configured, a single-buffer data message sent on an
+ * uncongested link is kept back so that messages following it within the
+ * delay can be bundled into the same packet. The caller is responsible for
+ * flushing the held bundle via tipc_link_hold_flush() once the delay expires.
+ *
+ * Return: true if the message in @list was absorbed into the held bundle.
+ * Otherwise any held bundle has been put in front of @list, so that it is
+ * sent ahead of the message.
+ */
+static bool tipc_link_hold(struct tipc_link *l, struct sk_buff_head *list,
+			   int imp, unsigned int mss)
+{
+	struct sk_buff *hskb = l->hold_bskb;
+	bool new_bundle = false;
+	struct sk_buff *skb;
+
+	if (!READ_ONCE(sysctl_tipc_bundle_delay) || link_is_bc_sndlink(l))
+		goto release;
+	if (skb_queue_len(list) != 1 || imp >= TIPC_SYSTEM_IMPORTANCE)
+		goto release;
+	if (skb_queue_len(&l->transmq) >= l->window ||
+	    !skb_queue_empty(&l->backlogq))
+		goto release;
+
+	skb = skb_peek(list);
+	if (!msg_isdata(buf_msg(skb)))
+		goto release;
+
+	if (!hskb) {
+		if (!tipc_msg_try_bundle(NULL, &skb, mss, l->addr, &new_bundle))
+			goto release;
+		__skb_unlink(skb, list);
+		l->hold_bskb = skb;
+		return true;
+	}
+
+	if (msg_importance(buf_msg(hskb)) != imp)
+		goto release;
+
+	__skb_unlink(skb, list);
+	if (tipc_msg_try_bundle(hskb, &skb, mss, l->addr, &new_bundle) &&
+	    !skb) {
+		if (new_bundle) {
+			l->stats.sent_bundles++;
+			l->stats.sent_bundled++;
+		}
+		l->stats.sent_bundled++;
+		return true;
+	}
+	__skb_queue_head(list, skb);
+
+release:
+	if (hskb) {
+		l->hold_bskb = NULL;
+		__skb_queue_head(list, hskb);
+	}
+	return false;
+}
+
+static int __tipc_link_xmit(struct tipc_link *l, struct sk_buff_head *list,
+			    struct sk_buff_head *xmitq, bool may_hold);
+
+/**
+ * tipc_link_hold_flush(): send a bundle held back by tipc_link_hold()
+ * @l: link to use
+ * @xmitq: returned list of packets to be sent by caller
+ */
+void tipc_link_hold_flush(struct tipc_link *l, struct sk_buff_head *xmitq)
+{
+	struct sk_buff_head list;
+
+	if (!l->hold_bskb)
+		return;
+
+	__skb_queue_head_init(&list);
+	__skb_queue_tail(&list, l->hold_bskb);
+	l->hold_bskb = NULL;
+	__tipc_link_xmit(l, &list, xmitq, false);
+}
+
+/**
+ * tipc_link_is_holding(): check for a bundle held back by tipc_link_hold()
+ * @l: link to check
+ */
+bool tipc_link_is_holding(struct tipc_link *l)
+{
+	return !!l->hold_bskb;
+}
+
 /**
  * tipc_link_xmit(): enqueue buffer list according to queue situation
  * @l: link to use
@@ -1013,6 +1110,12 @@ void tipc_link_reset(struct tipc_link *l)
  */
 int tipc_link_xmit(struct tipc_link *l, struct sk_buff_head *list,
 		   struct sk_buff_head *xmitq)
+{
+	return __tipc_link_xmit(l, list, xmitq, true);
+}
+
+static int __tipc_link_xmit(struct tipc_link *l, struct sk_buff_head *list,
+			    struct sk_buff_head *xmitq, bool may_hold)
 {
 	struct sk_buff_head *backlogq = &l->backlogq;
 	struct sk_buff_head *transmq = &l->transmq;
@@ -1051,6 +1154,15 @@ int tipc_link_xmit(struct tipc_link *l, struct sk_buff_head *list,
 		rc = link_schedule_user(l, hdr);
 	}
 
+	/* Bundle with, or send after, a message held back for bundling */
+	if (may_hold && !rc) {
+		if (tipc_link_hold(l, list, imp, mss))
+			return 0;
+	} else if (l->hold_bskb) {
+		__skb_queue_head(list, l->hold_bskb);
+		l->hold_bskb = NULL;
+	}
+
 	if (pkt_cnt > 1) {
 		l->stats.sent_fragmented++;
 		l->stats.sent_fragments += pkt_cnt;
@@ -1964,6 +2076,13 @@ void tipc_link_tnl_prepare(struct tipc_link *l, struct tipc_link *tnl,
 	if (!tnl)
 		return;
 
+	/* A bundle held back on this link must be included in the tunnelled
+	 * traffic, so move it onto the transmit queue first.
+	 */
+	__skb_queue_head_init(&tmpxq);
+	tipc_link_hold_flush(l, &tmpxq);
+	__skb_queue_purge(&tmpxq);
+
 	__skb_queue_head_init(&tnlq);
 	/* Link Synching:
 	 * From now on, send only one single ("dummy") SYNCH message
@@ -71,6 +71,8 @@ enum {
  */
 #define MAX_PKT_DEFAULT 1500
 
+extern int sysctl_tipc_bundle_delay __read_mostly;
+
 bool tipc_link_create(struct net *net, char *if_name, int bearer_id,
 		      int tolerance, char net_plane, u32 mtu, int priority,
 		      u32 min_win, u32 max_win, u32 session, u32 ownnode,
@@ -106,6 +108,8 @@ void tipc_link_reset(struct tipc_link *l);
 void tipc_link_reset_stats(struct tipc_link *l);
 int tipc_link_xmit(struct tipc_link *link, struct sk_buff_head *list,
 		   struct sk_buff_head *xmitq);
+void tipc_link_hold_flush(struct tipc_link *l, struct sk_buff_head *xmitq);
+bool tipc_link_is_holding(struct tipc_link *l);
 struct sk_buff_head *tipc_link_inputq(struct tipc_link *l);
 u16 tipc_link_rcv_nxt(struct tipc_link *l);
 u16 tipc_link_acked(struct tipc_link *l);
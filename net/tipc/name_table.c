@@ -58,6 +58,10 @@
  *   Used by closest_first lookup and multicast lookup algorithm
  * @all_publ: all publications identical to this one, whatever node and scope
  *   Used by round-robin lookup algorithm
+ * @local_cnt: number of entries in @local_publ
+ * @all_cnt: number of entries in @all_publ
+ * @rr: round-robin cursor used by lockless lookups to pick a publication
+ * @rcu: RCU callback head used for deferred freeing
  */
 struct service_range {
 	u32 lower;
@@ -66,6 +70,10 @@ struct service_range {
 	u32 max;
 	struct list_head local_publ;
 	struct list_head all_publ;
+	u32 local_cnt;
+	u32 all_cnt;
+	atomic_t rr;
+	struct rcu_head rcu;
 };
 
 /**
@@ -76,6 +84,8 @@ struct service_range {
  * @service_list: links to adjacent name ranges in hash chain
  * @subscriptions: list of subscriptions for this service type
  * @lock: spinlock controlling access to pertaining service ranges/publications
+ * @seq: bumped by @lock holders around @ranges tree updates, lets lookups
+ *   descend the tree without taking @lock
  * @rcu: RCU callback head used for deferred freeing
  */
 struct tipc_service {
@@ -85,6 +95,7 @@ struct tipc_service {
 	struct hlist_node service_list;
 	struct list_head subscriptions;
 	spinlock_t lock; /* Covers service range list */
+	seqcount_spinlock_t seq;
 	struct rcu_head rcu;
 };
 
@@ -215,6 +226,67 @@ static struct service_range *service_range_match_next(struct rb_node *n,
 	return NULL;
 }
 
+/**
+ * tipc_service_match_first_rcu - find first service range containing instance
+ * @sc: the tipc service to search
+ * @inst: the service instance to look up
+ *
+ * Descend the service range tree without taking the service lock, and only
+ * fall back to it if the tree changed under us. Service ranges are freed
+ * after an RCU grace period, so the result stays valid for as long as the
+ * caller is in its RCU read side critical section.
+ *
+ * Return: the leftmost service range containing @inst if any, otherwise NULL.
+ */
+static struct service_range *tipc_service_match_first_rcu(struct tipc_service *sc,
+							  u32 inst)
+{
+	struct service_range *sr;
+	unsigned int seq;
+
+	seq = read_seqcount_begin(&sc->seq);
+	sr = service_range_match_first(READ_ONCE(sc->ranges.rb_node), inst, inst);
+	if (!read_seqcount_retry(&sc->seq, seq))
+		return sr;
+
+	spin_lock_bh(&sc->lock);
+	sr = service_range_match_first(sc->ranges.rb_node, inst, inst);
+	spin_unlock_bh(&sc->lock);
+	return sr;
+}
+
+/**
+ * service_range_rr - pick the next publication of a list in round-robin order
+ * @sr: the service range owning the list
+ * @head: @sr->local_publ or @sr->all_publ
+ * @cnt: number of entries in @head
+ *
+ * Lookups may run concurrently with each other and with binding changes, so
+ * rather than rotating the list each lookup advances a cursor and walks to
+ * the entry it points at. If the list shrank in the meantime, the first entry
+ * is used.
+ *
+ * Return: the list node of the picked publication, or NULL if @head is empty.
+ */
+static struct list_head *service_range_rr(struct service_range *sr,
+					  struct list_head *head, u32 cnt)
+{
+	struct list_head *pos, *first = NULL;
+	u32 idx;
+
+	if (!cnt)
+		return NULL;
+
+	idx = (u32)atomic_inc_return(&sr->rr) % cnt;
+	list_for_each_rcu(pos, head) {
+		if (!first)
+			first = pos;
+		if (!idx--)
+			return pos;
+	}
+	return first;
+}
+
 static int hash(int x)
 {
 	return x & (TIPC_NAMETBL_SIZE - 1);
@@ -268,6 +340,7 @@ static struct tipc_service *tipc_service_create(struct net *net,
 	}
 
 	spin_lock_init(&service->lock);
+	seqcount_spinlock_init(&service->seq, &service->lock);
 	service->type = ua->sr.type;
 	service->ranges = RB_ROOT;
 	INIT_HLIST_NODE(&service->service_list);
@@ -297,9 +370,10 @@ static struct service_range *tipc_service_create_range(struct tipc_service *sc,
 						       struct publication *p)
 {
 	struct rb_node **n, *parent = NULL;
-	struct service_range *sr;
+	struct service_range *sr, *tmp;
 	u32 lower = p->sr.lower;
 	u32 upper = p->sr.upper;
+	struct rb_node *nd;
 
 	n = &sc->ranges.rb_node;
 	while (*n) {
@@ -307,8 +381,6 @@ static struct service_range *tipc_service_create_range(struct tipc_service *sc,
 		sr = service_range_entry(parent);
 		if (lower == sr->lower && upper == sr->upper)
 			return sr;
-		if (sr->max < upper)
-			sr->max = upper;
 		if (lower <= sr->lower)
 			n = &parent->rb_left;
 		else
@@ -322,8 +394,18 @@ static struct service_range *tipc_service_create_range(struct tipc_service *sc,
 	sr->max = upper;
 	INIT_LIST_HEAD(&sr->local_publ);
 	INIT_LIST_HEAD(&sr->all_publ);
-	rb_link_node(&sr->tree_node, parent, n);
+
+	write_seqcount_begin(&sc->seq);
+	/* Raise the subtree max along the insertion path found above */
+	for (nd = sc->ranges.rb_node; nd; ) {
+		tmp = service_range_entry(nd);
+		if (tmp->max < upper)
+			tmp->max = upper;
+		nd = lower <= tmp->lower ? nd->rb_left : nd->rb_right;
+	}
+	rb_link_node_rcu(&sr->tree_node, parent, n);
 	rb_insert_augmented(&sr->tree_node, &sc->ranges, &sr_callbacks);
+	write_seqcount_end(&sc->seq);
 	return sr;
 }
 
@@ -356,9 +438,12 @@ static bool tipc_service_insert_publ(struct net *net,
 		}
 	}
 
-	if (in_own_node(net, p->sk.node))
-		list_add(&p->local_publ, &sr->local_publ);
-	list_add(&p->all_publ, &sr->all_publ);
+	if (in_own_node(net, p->sk.node)) {
+		list_add_rcu(&p->local_publ, &sr->local_publ);
+		WRITE_ONCE(sr->local_cnt, sr->local_cnt + 1);
+	}
+	list_add_rcu(&p->all_publ, &sr->all_publ);
+	WRITE_ONCE(sr->all_cnt, sr->all_cnt + 1);
 	p->id = sc->publ_cnt++;
 
 	/* Any subscriptions waiting for notification?  */
@@ -390,8 +475,12 @@ static struct publication *tipc_service_remove_publ(struct service_range *r,
 	list_for_each_entry(p, &r->all_publ, all_publ) {
 		if (p->key != key || (node && node != p->sk.node))
 			continue;
-		list_del(&p->all_publ);
-		list_del(&p->local_publ);
+		if (!list_empty(&p->local_publ)) {
+			list_del_rcu(&p->local_publ);
+			WRITE_ONCE(r->local_cnt, r->local_cnt - 1);
+		}
+		list_del_rcu(&p->all_publ);
+		WRITE_ONCE(r->all_cnt, r->all_cnt - 1);
 		return p;
 	}
 	return NULL;
@@ -525,8 +614,10 @@ struct publication *tipc_nametbl_remove_publ(struct net *net,
 
 	/* Remove service range item if this was its last publication */
 	if (list_empty(&sr->all_publ)) {
+		write_seqcount_begin(&sc->seq);
 		rb_erase_augmented(&sr->tree_node, &sc->ranges, &sr_callbacks);
-		kfree(sr);
+		write_seqcount_end(&sc->seq);
+		kfree_rcu(sr, rcu);
 	}
 
 	/* Delete service item if no more publications and subscriptions */
@@ -565,6 +656,9 @@ struct publication *tipc_nametbl_remove_publ(struct net *net,
  * Note that for legacy users (node configured with Z.C.N address format) the
  * 'closest-first' lookup algorithm must be maintained, i.e., if sk.node is 0
  * we must look in the local binding list first
+ *
+ * The lookup only takes the service lock when a local binding is requested and
+ * the first matching range has none.
  */
 bool tipc_nametbl_lookup_anycast(struct net *net,
 				 struct tipc_uaddr *ua,
@@ -588,32 +682,34 @@ bool tipc_nametbl_lookup_anycast(struct net *net,
 	if (unlikely(!sc))
 		goto exit;
 
-	spin_lock_bh(&sc->lock);
-	service_range_foreach_match(r, sc, inst, inst) {
-		/* Select lookup algo: local, closest-first or round-robin */
-		if (sk->node == self) {
-			l = &r->local_publ;
-			if (list_empty(l))
-				continue;
-			p = list_first_entry(l, struct publication, local_publ);
-			list_move_tail(&p->local_publ, &r->local_publ);
-		} else if (legacy && !sk->node && !list_empty(&r->local_publ)) {
-			l = &r->local_publ;
-			p = list_first_entry(l, struct publication, local_publ);
-			list_move_tail(&p->local_publ, &r->local_publ);
-		} else {
-			l = &r->all_publ;
-			p = list_first_entry(l, struct publication, all_publ);
-			list_move_tail(&p->all_publ, &r->all_publ);
+	/* Todo: as for legacy, pick the first matching range only, a
+	 * "true" round-robin will be performed as needed.
+	 */
+	r = tipc_service_match_first_rcu(sc, inst);
+	if (r && sk->node == self && !READ_ONCE(r->local_cnt)) {
+		spin_lock_bh(&sc->lock);
+		service_range_foreach_match(r, sc, inst, inst) {
+			if (r->local_cnt)
+				break;
 		}
+		spin_unlock_bh(&sc->lock);
+	}
+	if (!r)
+		goto exit;
+
+	/* Select lookup algo: local, closest-first or round-robin */
+	if (sk->node == self || (legacy && !sk->node &&
+				 READ_ONCE(r->local_cnt))) {
+		l = service_range_rr(r, &r->local_publ, READ_ONCE(r->local_cnt));
+		p = l ? list_entry(l, struct publication, local_publ) : NULL;
+	} else {
+		l = service_range_rr(r, &r->all_publ, READ_ONCE(r->all_cnt));
+		p = l ? list_entry(l, struct publication, all_publ) : NULL;
+	}
+	if (p) {
 		*sk = p->sk;
 		res = true;
-		/* Todo: as for legacy, pick the first matching range only, a
-		 * "true" round-robin will be performed as needed.
-		 */
-		break;
 	}
-	spin_unlock_bh(&sc->lock);
 
 exit:
 	rcu_read_unlock();
@@ -629,11 +725,13 @@ bool tipc_nametbl_lookup_group(struct net *net, struct tipc_uaddr *ua,
 			       struct list_head *dsts, int *dstcnt,
 			       u32 exclude, bool mcast)
 {
+	struct publication *p, *pick = NULL;
 	u32 self = tipc_own_addr(net);
 	u32 inst = ua->sa.instance;
 	struct service_range *sr;
 	struct tipc_service *sc;
-	struct publication *p;
+	u32 i = 0, idx = 0;
+	bool before;
 
 	*dstcnt = 0;
 	rcu_read_lock();
@@ -641,27 +739,41 @@ bool tipc_nametbl_lookup_group(struct net *net, struct tipc_uaddr *ua,
 	if (unlikely(!sc))
 		goto exit;
 
-	spin_lock_bh(&sc->lock);
-
 	/* Todo: a full search i.e. service_range_foreach_match() instead? */
-	sr = service_range_match_first(sc->ranges.rb_node, inst, inst);
+	sr = tipc_service_match_first_rcu(sc, inst);
 	if (!sr)
-		goto no_match;
+		goto exit;
+
+	/* For anycast, pick the first eligible member at or after the
+	 * round-robin cursor, wrapping around to the first one before it.
+	 */
+	if (!mcast)
+		idx = (u32)atomic_inc_return(&sr->rr) %
+		      max_t(u32, READ_ONCE(sr->all_cnt), 1);
 
-	list_for_each_entry(p, &sr->all_publ, all_publ) {
+	list_for_each_entry_rcu(p, &sr->all_publ, all_publ) {
+		before = i++ < idx;
 		if (p->scope != ua->scope)
 			continue;
 		if (p->sk.ref == exclude && p->sk.node == self)
 			continue;
-		tipc_dest_push(dsts, p->sk.node, p->sk.ref);
-		(*dstcnt)++;
-		if (mcast)
+		if (mcast) {
+			tipc_dest_push(dsts, p->sk.node, p->sk.ref);
+			(*dstcnt)++;
+			continue;
+		}
+		if (before) {
+			if (!pick)
+				pick = p;
 			continue;
-		list_move_tail(&p->all_publ, &sr->all_publ);
+		}
+		pick = p;
 		break;
 	}
-no_match:
-	spin_unlock_bh(&sc->lock);
+	if (pick) {
+		tipc_dest_push(dsts, pick->sk.node, pick->sk.ref);
+		(*dstcnt)++;
+	}
 exit:
 	rcu_read_unlock();
 	return !list_empty(dsts);
@@ -919,8 +1031,10 @@ static void tipc_service_delete(struct net *net, struct tipc_service *sc)
 			tipc_service_remove_publ(sr, &p->sk, p->key);
 			kfree_rcu(p, rcu);
 		}
+		write_seqcount_begin(&sc->seq);
 		rb_erase_augmented(&sr->tree_node, &sc->ranges, &sr_callbacks);
-		kfree(sr);
+		write_seqcount_end(&sc->seq);
+		kfree_rcu(sr, rcu);
 	}
 	hlist_del_init_rcu(&sc->service_list);
 	spin_unlock_bh(&sc->lock);
@@ -105,6 +105,8 @@ struct tipc_bclink_entry {
  * @publ_list: list of publications
  * @conn_sks: list of connections (FIXME)
  * @timer: node's keepalive timer
+ * @hold_timer: flushes messages held back for bundling on the node's links
+ * @hold_armed: @hold_timer is pending and holds a node reference
  * @keepalive_intv: keepalive interval in milliseconds
  * @rcu: rcu struct for tipc_node
  * @delete_at: indicates the time for deleting a down node
@@ -138,6 +140,8 @@ struct tipc_node {
 	struct list_head conn_sks;
 	unsigned long keepalive_intv;
 	struct timer_list timer;
+	struct hrtimer hold_timer;
+	unsigned long hold_armed;
 	struct rcu_head rcu;
 	unsigned long delete_at;
 	struct net *peer_net;
@@ -179,6 +183,7 @@ static void tipc_node_link_down(struct tipc_node *n, int bearer_id,
 static void node_lost_contact(struct tipc_node *n, struct sk_buff_head *inputq);
 static void tipc_node_delete(struct tipc_node *node);
 static void tipc_node_timeout(struct timer_list *t);
+static enum hrtimer_restart tipc_node_hold_timeout(struct hrtimer *t);
 static void tipc_node_fsm_evt(struct tipc_node *n, int evt);
 static struct tipc_node *tipc_node_find(struct net *net, u32 addr);
 static struct tipc_node *tipc_node_find_by_id(struct net *net, u8 *id);
@@ -587,6 +592,8 @@ struct tipc_node *tipc_node_create(struct net *net, u32 addr, u8 *peer_id,
 	}
 	tipc_node_get(n);
 	timer_setup(&n->timer, tipc_node_timeout, 0);
+	hrtimer_init(&n->hold_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL_SOFT);
+	n->hold_timer.function = tipc_node_hold_timeout;
 	/* Start a slow timer anyway, crypto needs it */
 	n->keepalive_intv = 10000;
 	intv = jiffies + msecs_to_jiffies(n->keepalive_intv);
@@ -639,6 +646,8 @@ static void tipc_node_delete(struct tipc_node *node)
 	tipc_node_delete_from_list(node);
 
 	del_timer_sync(&node->timer);
+	if (hrtimer_cancel(&node->hold_timer))
+		tipc_node_put(node);
 	tipc_node_put(node);
 }
 
@@ -1690,6 +1699,7 @@ int tipc_node_xmit(struct net *net, struct sk_buff_head *list,
 	struct tipc_link_entry *le = NULL;
 	struct tipc_node *n;
 	struct sk_buff_head xmitq;
+	bool holding = false;
 	bool node_up = false;
 	struct net *peer_net;
 	int bearer_id;
@@ -1737,9 +1747,17 @@ int tipc_node_xmit(struct net *net, struct sk_buff_head *list,
 	le = &n->links[bearer_id];
 	spin_lock_bh(&le->lock);
 	rc = tipc_link_xmit(le->link, list, &xmitq);
+	holding = tipc_link_is_holding(le->link);
 	spin_unlock_bh(&le->lock);
 	tipc_node_read_unlock(n);
 
+	if (holding && !test_and_set_bit(0, &n->hold_armed)) {
+		tipc_node_get(n);
+		hrtimer_start(&n->hold_timer,
+			      (u64)READ_ONCE(sysctl_tipc_bundle_delay) * NSEC_PER_USEC,
+			      HRTIMER_MODE_REL_SOFT);
+	}
+
 	if (unlikely(rc == -ENOBUFS))
 		tipc_node_link_down(n, bearer_id, false);
 	else
@@ -1750,6 +1768,37 @@ int tipc_node_xmit(struct net *net, struct sk_buff_head *list,
 	return rc;
 }
 
+/* tipc_node_hold_timeout(): send messages held back for bundling once the
+ * bundle delay has expired
+ */
+static enum hrtimer_restart tipc_node_hold_timeout(struct hrtimer *t)
+{
+	struct tipc_node *n = container_of(t, struct tipc_node, hold_timer);
+	struct tipc_link_entry *le;
+	struct sk_buff_head xmitq;
+	int bearer_id;
+
+	clear_bit(0, &n->hold_armed);
+	__skb_queue_head_init(&xmitq);
+
+	for (bearer_id = 0; bearer_id < MAX_BEARERS; bearer_id++) {
+		tipc_node_read_lock(n);
+		le = &n->links[bearer_id];
+		if (le->link) {
+			spin_lock_bh(&le->lock);
+			tipc_link_hold_flush(le->link, &xmitq);
+			spin_unlock_bh(&le->lock);
+		}
+		tipc_node_read_unlock(n);
+		if (!skb_queue_empty(&xmitq))
+			tipc_bearer_xmit(n->net, bearer_id, &xmitq, &le->maddr,
+					 n);
+	}
+
+	tipc_node_put(n);
+	return HRTIMER_NORESTART;
+}
+
 /* tipc_node_xmit_skb(): send single buffer to destination
  * Buffers sent via this function are generally TIPC_SYSTEM_IMPORTANCE
  * messages, which will not be rejected
@@ -2325,11 +2325,14 @@ static unsigned int rcvbuf_limit(struct sock *sk, struct sk_buff *skb)
  * @xmitq: output message area (FIXME)
  *
  * Enqueues message on receive queue if acceptable; optionally handles
- * disconnect indication for a connected socket.
+ * disconnect indication for a connected socket. The caller is responsible
+ * for waking up the reader, so that a batch of messages costs one wakeup.
  *
  * Called with socket lock already taken
+ *
+ * Return: true if any message was added to the receive queue
  */
-static void tipc_sk_filter_rcv(struct sock *sk, struct sk_buff *skb,
+static bool tipc_sk_filter_rcv(struct sock *sk, struct sk_buff *skb,
 			       struct sk_buff_head *xmitq)
 {
 	bool sk_conn = !tipc_sk_type_connectionless(sk);
@@ -2340,6 +2343,7 @@ static void tipc_sk_filter_rcv(struct sock *sk, struct sk_buff *skb,
 	struct sk_buff_head inputq;
 	int mtyp = msg_type(hdr);
 	int limit, err = TIPC_OK;
+	bool queued = false;
 
 	trace_tipc_sk_filter_rcv(sk, skb, TIPC_DUMP_ALL, " ");
 	TIPC_SKB_CB(skb)->bytes_read = 0;
@@ -2383,8 +2387,9 @@ static void tipc_sk_filter_rcv(struct sock *sk, struct sk_buff *skb,
 		skb_set_owner_r(skb, sk);
 		trace_tipc_sk_overlimit2(sk, skb, TIPC_DUMP_ALL,
 					 "rcvq >90% allocated!");
-		sk->sk_data_ready(sk);
+		queued = true;
 	}
+	return queued;
 }
 
 /**
@@ -2402,7 +2407,8 @@ static int tipc_sk_backlog_rcv(struct sock *sk, struct sk_buff *skb)
 
 	__skb_queue_head_init(&xmitq);
 
-	tipc_sk_filter_rcv(sk, skb, &xmitq);
+	if (tipc_sk_filter_rcv(sk, skb, &xmitq))
+		sk->sk_data_ready(sk);
 	added = sk_rmem_alloc_get(sk) - before;
 	atomic_add(added, &tipc_sk(sk)->dupl_rcvcnt);
 
@@ -2426,21 +2432,22 @@ static void tipc_sk_enqueue(struct sk_buff_head *inputq, struct sock *sk,
 {
 	unsigned long time_limit = jiffies + usecs_to_jiffies(20000);
 	struct sk_buff *skb;
+	bool wake = false;
 	unsigned int lim;
 	atomic_t *dcnt;
 	u32 onode;
 
 	while (skb_queue_len(inputq)) {
 		if (unlikely(time_after_eq(jiffies, time_limit)))
-			return;
+			break;
 
 		skb = tipc_skb_dequeue(inputq, dport);
 		if (unlikely(!skb))
-			return;
+			break;
 
 		/* Add message directly to receive queue if possible */
 		if (!sock_owned_by_user(sk)) {
-			tipc_sk_filter_rcv(sk, skb, xmitq);
+			wake |= tipc_sk_filter_rcv(sk, skb, xmitq);
 			continue;
 		}
 
@@ -2466,6 +2473,10 @@ static void tipc_sk_enqueue(struct sk_buff_head *inputq, struct sock *sk,
 		}
 		break;
 	}
+
+	/* One wakeup for the whole batch delivered to the receive queue */
+	if (wake)
+		sk->sk_data_ready(sk);
 }
 
 /**
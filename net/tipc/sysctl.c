@@ -37,9 +37,12 @@
 #include "trace.h"
 #include "crypto.h"
 #include "bcast.h"
+#include "link.h"
 #include <linux/sysctl.h>
 
 static struct ctl_table_header *tipc_ctl_hdr;
+/* bundle_delay is in usecs, never hold messages back for more than 1s */
+static int tipc_bundle_delay_max = USEC_PER_SEC;
 
 static struct ctl_table tipc_table[] = {
 	{
@@ -84,6 +87,15 @@ static struct ctl_table tipc_table[] = {
 		.extra2         = SYSCTL_ONE,
 	},
 #endif
+	{
+		.procname	= "bundle_delay",
+		.data		= &sysctl_tipc_bundle_delay,
+		.maxlen		= sizeof(sysctl_tipc_bundle_delay),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1         = SYSCTL_ZERO,
+		.extra2         = &tipc_bundle_delay_max,
+	},
 	{
 		.procname	= "bc_retruni",
 		.data		= &sysctl_tipc_bc_retruni,
@@ -611,6 +611,16 @@ int xfrm_input(struct sk_buff *skb, int nexthdr, __be32 spi, int encap_type)
 		}
 
 lock:
+		/* In-order packets on a live SA do not need x->lock before
+		 * decryption: the replay window is checked again and advanced
+		 * under the lock once the packet is authenticated.
+		 */
+		if (likely(READ_ONCE(x->km.state) == XFRM_STATE_VALID &&
+			   (x->encap ? x->encap->encap_type : 0) == encap_type &&
+			   xfrm_replay_check_ahead(x, seq) &&
+			   xfrm_state_expire_nolock_ok(x)))
+			goto checked;
+
 		spin_lock(&x->lock);
 
 		if (unlikely(x->km.state != XFRM_STATE_VALID)) {
@@ -639,6 +649,7 @@ int xfrm_input(struct sk_buff *skb, int nexthdr, __be32 spi, int encap_type)
 
 		spin_unlock(&x->lock);
 
+checked:
 		if (xfrm_tunnel_check(skb, x, family)) {
 			XFRM_INC_STATS(net, LINUX_MIB_XFRMINSTATEMODEERROR);
 			goto drop;
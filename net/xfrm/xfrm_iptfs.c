@@ -8,12 +8,16 @@
  */
 
 #include <linux/kernel.h>
+#include <linux/average.h>
 #include <linux/icmpv6.h>
+#include <linux/seq_file.h>
 #include <linux/skbuff_ref.h>
+#include <linux/sysctl.h>
 #include <net/gro.h>
 #include <net/icmp.h>
 #include <net/ip6_route.h>
 #include <net/inet_ecn.h>
+#include <net/netns/generic.h>
 #include <net/xfrm.h>
 
 #include <crypto/aead.h>
@@ -66,6 +70,17 @@
  */
 #define IPTFS_DEFAULT_INIT_DELAY_USECS 0
 
+/**
+ * define IPTFS_ADAPTIVE_MAX_DELAY_USECS - adaptive mode delay ceiling.
+ *
+ * In adaptive mode the output delay is derived from the measured inner
+ * traffic rate and bounded by the SA initial delay. When the SA has no initial
+ * delay configured this value is used as the bound instead.
+ *
+ * Default 100us.
+ */
+#define IPTFS_ADAPTIVE_MAX_DELAY_USECS 100
+
 /**
  * define IPTFS_DEFAULT_MAX_QUEUE_SIZE - default max output queue size.
  *
@@ -123,6 +138,58 @@ struct skb_wseq {
 	u64 drop_time;
 };
 
+/* Inner traffic rate estimators for adaptive mode */
+DECLARE_EWMA(iptfs_gap, 4, 8)
+DECLARE_EWMA(iptfs_bytes, 4, 8)
+
+/**
+ * struct iptfs_stats - per-cpu IPTFS output counters.
+ * @outer_pkts: outer IPTFS packets built from the output queue.
+ * @payload_bytes: inner octets carried in those outer packets.
+ * @unused_bytes: outer packet capacity left unfilled, i.e., the octets a
+ *	fixed-size outer packet would have needed as padding.
+ * @timer_flushes: output queue services run by the delay timer.
+ * @early_flushes: adaptive mode timer re-arms because a full outer packet
+ *	worth of data was queued.
+ * @queue_delay_us: summed time, in microseconds, from the first packet being
+ *	queued to the queue being serviced.
+ */
+struct iptfs_stats {
+	unsigned long outer_pkts;
+	unsigned long payload_bytes;
+	unsigned long unused_bytes;
+	unsigned long timer_flushes;
+	unsigned long early_flushes;
+	unsigned long queue_delay_us;
+};
+
+/**
+ * struct iptfs_net - per network namespace IPTFS data.
+ * @stats: output counters, reported in /proc/net/xfrm_stat. Cleared on
+ *	namespace exit, which runs before the xfrm core flushes the SAs whose
+ *	timers may still update it.
+ * @dead_stats: @stats awaiting an RCU grace period to be freed.
+ * @sysctl_hdr: sysctl registration for @adaptive.
+ * @adaptive: non-zero to derive the output delay from the inner traffic rate.
+ */
+struct iptfs_net {
+	struct iptfs_stats __percpu __rcu *stats;
+	struct iptfs_stats __percpu *dead_stats;
+	struct ctl_table_header *sysctl_hdr;
+	int adaptive;
+};
+
+static unsigned int iptfs_net_id __read_mostly;
+
+/* Return this CPU's output counters for `net`, or NULL once it is exiting. */
+static struct iptfs_stats *iptfs_this_cpu_stats(struct net *net)
+{
+	struct iptfs_net *in = net_generic(net, iptfs_net_id);
+	struct iptfs_stats __percpu *stats = rcu_dereference_bh(in->stats);
+
+	return stats ? this_cpu_ptr(stats) : NULL;
+}
+
 /**
  * struct xfrm_iptfs_data - mode specific xfrm state.
  * @cfg: IPTFS tunnel config.
@@ -134,6 +201,10 @@ struct skb_wseq {
  * @iptfs_timer: output timer.
  * @iptfs_settime: time the output timer was set.
  * @payload_mtu: max payload size.
+ * @ad_last_ns: time of the last output collection (adaptive mode).
+ * @ad_gap: average time between output collections (adaptive mode).
+ * @ad_bytes: average octets queued per output collection (adaptive mode).
+ * @ad_mtu: outer packet payload size last used when servicing the queue.
  * @w_seq_set: true after first seq received.
  * @w_wantseq: waiting for this seq number as next to process (in order).
  * @w_saved: the saved buf array (reorder window).
@@ -159,6 +230,10 @@ struct xfrm_iptfs_data {
 	struct hrtimer iptfs_timer; /* output timer */
 	time64_t iptfs_settime;	    /* time timer was set */
 	u32 payload_mtu;	    /* max payload size */
+	u64 ad_last_ns;		    /* last collection time */
+	struct ewma_iptfs_gap ad_gap;
+	struct ewma_iptfs_bytes ad_bytes;
+	u32 ad_mtu;		    /* last outer payload size */
 
 	/* Tunnel input reordering */
 	bool w_seq_set;		  /* true after first seq received */
@@ -1812,6 +1887,73 @@ static int iptfs_is_too_big(struct sock *sk, struct sk_buff *skb, u32 pmtu)
 	return 1;
 }
 
+/**
+ * iptfs_adaptive_delay() - compute the output delay from the inner rate.
+ * @xtfs: xtfs state
+ * @added: octets queued by the current collection
+ *
+ * Track the average time between output collections and the average octets
+ * they queue, and from these estimate how long it takes to fill an outer
+ * packet. If that fits within the delay bound wait exactly that long, so bulk
+ * flows send full outer packets. Otherwise the outer packet would not fill
+ * before the bound anyway and waiting only adds latency, so send at once.
+ *
+ * Return: the delay in nanoseconds to use for the output timer.
+ */
+static u64 iptfs_adaptive_delay(struct xfrm_iptfs_data *xtfs, u32 added)
+{
+	u64 max_ns = xtfs->init_delay_ns ?:
+		     IPTFS_ADAPTIVE_MAX_DELAY_USECS * NSECS_IN_USEC;
+	u32 mtu = READ_ONCE(xtfs->ad_mtu);
+	u64 now = ktime_get_raw_fast_ns();
+	unsigned long gap, bytes;
+	u64 fill_ns;
+
+	assert_spin_locked(&xtfs->x->lock);
+
+	/* Idle periods longer than the bound carry no rate information. */
+	gap = min_t(u64, now - xtfs->ad_last_ns, max_ns);
+	xtfs->ad_last_ns = now;
+	if (!added)
+		return max_ns;
+
+	ewma_iptfs_gap_add(&xtfs->ad_gap, gap);
+	ewma_iptfs_bytes_add(&xtfs->ad_bytes, added);
+
+	gap = ewma_iptfs_gap_read(&xtfs->ad_gap);
+	bytes = ewma_iptfs_bytes_read(&xtfs->ad_bytes);
+	if (!mtu || !bytes)
+		return max_ns;
+
+	fill_ns = div_u64((u64)mtu * gap, bytes);
+	return fill_ns <= max_ns ? fill_ns : 0;
+}
+
+/**
+ * iptfs_adaptive_flush() - service the queue now if it fills an outer packet.
+ * @net: network namespace
+ * @xtfs: xtfs state
+ *
+ * Return: true if the queue holds at least one full outer packet of data, in
+ * which case a running delay timer has been moved to expire immediately.
+ */
+static bool iptfs_adaptive_flush(struct net *net, struct xfrm_iptfs_data *xtfs)
+{
+	u32 mtu = READ_ONCE(xtfs->ad_mtu);
+	struct iptfs_stats *stats;
+
+	if (!mtu || xtfs->queue_size < mtu)
+		return false;
+
+	if (hrtimer_is_queued(&xtfs->iptfs_timer)) {
+		hrtimer_start(&xtfs->iptfs_timer, 0, IPTFS_HRTIMER_MODE);
+		stats = iptfs_this_cpu_stats(net);
+		if (stats)
+			stats->early_flushes++;
+	}
+	return true;
+}
+
 /* IPv4/IPv6 packet ingress to IPTFS tunnel, arrange to send in IPTFS payload
  * (i.e., aggregating or fragmenting as appropriate).
  * This is set in dst->output for an SA.
@@ -1821,10 +1963,13 @@ static int iptfs_output_collect(struct net *net, struct sock *sk, struct sk_buff
 	struct dst_entry *dst = skb_dst(skb);
 	struct xfrm_state *x = dst->xfrm;
 	struct xfrm_iptfs_data *xtfs = x->mode_data;
+	struct iptfs_net *in = net_generic(net, iptfs_net_id);
 	struct sk_buff *segs, *nskb;
 	u32 pmtu = 0;
 	bool ok = true;
 	bool was_gso;
+	u32 qsize;
+	u64 delay;
 
 	/* We have hooked into dst_entry->output which means we have skipped the
 	 * protocol specific netfilter (see xfrm4_output, xfrm6_output).
@@ -1868,6 +2013,7 @@ static int iptfs_output_collect(struct net *net, struct sock *sk, struct sk_buff
 	 * from user context depending on where the packet is coming from.
 	 */
 	spin_lock_bh(&x->lock);
+	qsize = xtfs->queue_size;
 
 	skb_list_walk_safe(segs, skb, nskb) {
 		skb_mark_not_on_list(skb);
@@ -1900,11 +2046,19 @@ static int iptfs_output_collect(struct net *net, struct sock *sk, struct sk_buff
 		trace_iptfs_enqueue(skb, xtfs, pmtu, was_gso);
 	}
 
+	if (READ_ONCE(in->adaptive)) {
+		delay = iptfs_adaptive_delay(xtfs, xtfs->queue_size - qsize);
+		if (iptfs_adaptive_flush(net, xtfs))
+			delay = 0;
+	} else {
+		delay = xtfs->init_delay_ns;
+	}
+
 	/* Start a delay timer if we don't have one yet */
 	if (!hrtimer_is_queued(&xtfs->iptfs_timer)) {
-		hrtimer_start(&xtfs->iptfs_timer, xtfs->init_delay_ns, IPTFS_HRTIMER_MODE);
+		hrtimer_start(&xtfs->iptfs_timer, delay, IPTFS_HRTIMER_MODE);
 		xtfs->iptfs_settime = ktime_get_raw_fast_ns();
-		trace_iptfs_timer_start(xtfs, xtfs->init_delay_ns);
+		trace_iptfs_timer_start(xtfs, delay);
 	}
 
 	spin_unlock_bh(&x->lock);
@@ -2169,6 +2323,7 @@ static void iptfs_consume_frags(struct sk_buff *to, struct sk_buff *from)
 
 static void iptfs_output_queued(struct xfrm_state *x, struct sk_buff_head *list)
 {
+	struct iptfs_stats *stats = iptfs_this_cpu_stats(xs_net(x));
 	struct xfrm_iptfs_data *xtfs = x->mode_data;
 	struct sk_buff *skb, *skb2, **nextp;
 	struct skb_shared_info *shi, *shi2;
@@ -2298,6 +2453,13 @@ static void iptfs_output_queued(struct xfrm_state *x, struct sk_buff_head *list)
 			}
 		}
 
+		WRITE_ONCE(xtfs->ad_mtu, mtu);
+		if (stats) {
+			stats->outer_pkts++;
+			stats->payload_bytes += mtu - remaining;
+			stats->unused_bytes += remaining;
+		}
+
 		xfrm_output(NULL, skb);
 	}
 }
@@ -2306,8 +2468,10 @@ static enum hrtimer_restart iptfs_delay_timer(struct hrtimer *me)
 {
 	struct sk_buff_head list;
 	struct xfrm_iptfs_data *xtfs;
+	struct iptfs_stats *stats;
 	struct xfrm_state *x;
 	time64_t settime;
+	u64 delay;
 
 	xtfs = container_of(me, typeof(*xtfs), iptfs_timer);
 	x = xtfs->x;
@@ -2333,7 +2497,14 @@ static enum hrtimer_restart iptfs_delay_timer(struct hrtimer *me)
 	 * already).
 	 */
 
-	trace_iptfs_timer_expire(xtfs, (unsigned long long)(ktime_get_raw_fast_ns() - settime));
+	delay = ktime_get_raw_fast_ns() - settime;
+	trace_iptfs_timer_expire(xtfs, (unsigned long long)delay);
+
+	stats = iptfs_this_cpu_stats(xs_net(x));
+	if (stats) {
+		stats->timer_flushes++;
+		stats->queue_delay_us += div_u64(delay, NSECS_IN_USEC);
+	}
 
 	iptfs_output_queued(x, &list);
 
@@ -2632,6 +2803,9 @@ static void __iptfs_init_state(struct xfrm_state *x,
 	hrtimer_init(&xtfs->drop_timer, CLOCK_MONOTONIC, IPTFS_HRTIMER_MODE);
 	xtfs->drop_timer.function = iptfs_drop_timer;
 
+	ewma_iptfs_gap_init(&xtfs->ad_gap);
+	ewma_iptfs_bytes_init(&xtfs->ad_bytes);
+
 	/* Modify type (esp) adjustment values */
 
 	if (x->props.family == AF_INET)
@@ -2726,6 +2900,41 @@ static void iptfs_destroy_state(struct xfrm_state *x)
 	module_put(x->mode_cbs->owner);
 }
 
+static void iptfs_proc_show(struct net *net, struct seq_file *seq)
+{
+	struct iptfs_net *in = net_generic(net, iptfs_net_id);
+	struct iptfs_stats __percpu *pcpu_stats;
+	struct iptfs_stats sum = {};
+	struct iptfs_stats *stats;
+	int cpu;
+
+	pcpu_stats = rcu_dereference(in->stats);
+	if (!pcpu_stats)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		stats = per_cpu_ptr(pcpu_stats, cpu);
+		sum.outer_pkts += READ_ONCE(stats->outer_pkts);
+		sum.payload_bytes += READ_ONCE(stats->payload_bytes);
+		sum.unused_bytes += READ_ONCE(stats->unused_bytes);
+		sum.timer_flushes += READ_ONCE(stats->timer_flushes);
+		sum.early_flushes += READ_ONCE(stats->early_flushes);
+		sum.queue_delay_us += READ_ONCE(stats->queue_delay_us);
+	}
+
+	seq_printf(seq, "%-24s\t%lu\n", "XfrmOutIptfsPkts", sum.outer_pkts);
+	seq_printf(seq, "%-24s\t%lu\n", "XfrmOutIptfsPayload",
+		   sum.payload_bytes);
+	seq_printf(seq, "%-24s\t%lu\n", "XfrmOutIptfsUnused",
+		   sum.unused_bytes);
+	seq_printf(seq, "%-24s\t%lu\n", "XfrmOutIptfsTimerFlush",
+		   sum.timer_flushes);
+	seq_printf(seq, "%-24s\t%lu\n", "XfrmOutIptfsEarlyFlush",
+		   sum.early_flushes);
+	seq_printf(seq, "%-24s\t%lu\n", "XfrmOutIptfsQueueDelayUs",
+		   sum.queue_delay_us);
+}
+
 static const struct xfrm_mode_cbs iptfs_mode_cbs = {
 	.owner = THIS_MODULE,
 	.init_state = iptfs_init_state,
@@ -2738,6 +2947,116 @@ static const struct xfrm_mode_cbs iptfs_mode_cbs = {
 	.input = iptfs_input,
 	.output = iptfs_output_collect,
 	.prepare_output = iptfs_prepare_output,
+	.proc_show = iptfs_proc_show,
+};
+
+/* ================================= */
+/* Per network namespace data/sysctl */
+/* ================================= */
+
+#ifdef CONFIG_SYSCTL
+static struct ctl_table iptfs_sysctl_table[] = {
+	{
+		.procname	= "xfrm_iptfs_adaptive",
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= SYSCTL_ONE,
+	},
+};
+
+static int __net_init iptfs_sysctl_init(struct net *net, struct iptfs_net *in)
+{
+	size_t table_size = ARRAY_SIZE(iptfs_sysctl_table);
+	struct ctl_table *table;
+
+	table = kmemdup(iptfs_sysctl_table, sizeof(iptfs_sysctl_table),
+			GFP_KERNEL);
+	if (!table)
+		return -ENOMEM;
+	table[0].data = &in->adaptive;
+
+	/* Don't export sysctls to unprivileged users */
+	if (net->user_ns != &init_user_ns)
+		table_size = 0;
+
+	in->sysctl_hdr = register_net_sysctl_sz(net, "net/core", table,
+						table_size);
+	if (!in->sysctl_hdr) {
+		kfree(table);
+		return -ENOMEM;
+	}
+	return 0;
+}
+
+static void __net_exit iptfs_sysctl_fini(struct iptfs_net *in)
+{
+	const struct ctl_table *table;
+
+	table = in->sysctl_hdr->ctl_table_arg;
+	unregister_net_sysctl_table(in->sysctl_hdr);
+	kfree(table);
+}
+#else
+static int __net_init iptfs_sysctl_init(struct net *net, struct iptfs_net *in)
+{
+	return 0;
+}
+
+static void __net_exit iptfs_sysctl_fini(struct iptfs_net *in)
+{
+}
+#endif
+
+static int __net_init iptfs_net_init(struct net *net)
+{
+	struct iptfs_net *in = net_generic(net, iptfs_net_id);
+	struct iptfs_stats __percpu *stats;
+	int err;
+
+	stats = alloc_percpu(struct iptfs_stats);
+	if (!stats)
+		return -ENOMEM;
+
+	err = iptfs_sysctl_init(net, in);
+	if (err) {
+		free_percpu(stats);
+		return err;
+	}
+	RCU_INIT_POINTER(in->stats, stats);
+	return 0;
+}
+
+static void __net_exit iptfs_net_exit(struct net *net)
+{
+	struct iptfs_net *in = net_generic(net, iptfs_net_id);
+
+	iptfs_sysctl_fini(in);
+	in->dead_stats = rcu_replace_pointer(in->stats, NULL, true);
+}
+
+static void __net_exit iptfs_net_exit_batch(struct list_head *net_exit_list)
+{
+	struct iptfs_net *in;
+	struct net *net;
+
+	/* Output timers run in softirq context, wait for any still using the
+	 * stats of the exiting namespaces.
+	 */
+	synchronize_rcu();
+	list_for_each_entry(net, net_exit_list, exit_list) {
+		in = net_generic(net, iptfs_net_id);
+		free_percpu(in->dead_stats);
+	}
+}
+
+static struct pernet_operations iptfs_net_ops = {
+	.init = iptfs_net_init,
+	.exit = iptfs_net_exit,
+	.exit_batch = iptfs_net_exit_batch,
+	.id = &iptfs_net_id,
+	.size = sizeof(struct iptfs_net),
 };
 
 static int __init xfrm_iptfs_init(void)
@@ -2746,9 +3065,15 @@ static int __init xfrm_iptfs_init(void)
 
 	pr_info("xfrm_iptfs: IPsec IP-TFS tunnel mode module\n");
 
-	err = xfrm_register_mode_cbs(XFRM_MODE_IPTFS, &iptfs_mode_cbs);
+	err = register_pernet_subsys(&iptfs_net_ops);
 	if (err < 0)
+		return err;
+
+	err = xfrm_register_mode_cbs(XFRM_MODE_IPTFS, &iptfs_mode_cbs);
+	if (err < 0) {
 		pr_info("%s: can't register IP-TFS\n", __func__);
+		unregister_pernet_subsys(&iptfs_net_ops);
+	}
 
 	return err;
 }
@@ -2756,6 +3081,7 @@ static int __init xfrm_iptfs_init(void)
 static void __exit xfrm_iptfs_fini(void)
 {
 	xfrm_unregister_mode_cbs(XFRM_MODE_IPTFS);
+	unregister_pernet_subsys(&iptfs_net_ops);
 }
 
 module_init(xfrm_iptfs_init);
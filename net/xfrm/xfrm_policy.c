@@ -16,6 +16,7 @@
 
 #include <linux/err.h>
 #include <linux/slab.h>
+#include <linux/list_sort.h>
 #include <linux/kmod.h>
 #include <linux/list.h>
 #include <linux/spinlock.h>
@@ -436,6 +437,7 @@ struct xfrm_policy *xfrm_policy_alloc(struct net *net, gfp_t gfp)
 		INIT_LIST_HEAD(&policy->walk.all);
 		INIT_HLIST_HEAD(&policy->state_cache_list);
 		INIT_HLIST_NODE(&policy->bydst);
+		INIT_LIST_HEAD(&policy->bydst_reinsert);
 		INIT_HLIST_NODE(&policy->byidx);
 		rwlock_init(&policy->lock);
 		refcount_set(&policy->refcnt, 1);
@@ -889,26 +891,45 @@ static int xfrm_policy_addr_delta(const xfrm_address_t *a,
 	return delta;
 }
 
+static int xfrm_policy_reinsert_cmp(void *priv, const struct list_head *a,
+				    const struct list_head *b)
+{
+	const struct xfrm_policy *pa, *pb;
+
+	pa = list_entry(a, struct xfrm_policy, bydst_reinsert);
+	pb = list_entry(b, struct xfrm_policy, bydst_reinsert);
+
+	return pa->pos > pb->pos;
+}
+
+/* Move the policies queued on @reinsert into node @n.
+ *
+ * Only the policies taken off the merged nodes are visited, oldest first,
+ * instead of walking every policy of the netns for each merge.
+ */
 static void xfrm_policy_inexact_list_reinsert(struct net *net,
 					      struct xfrm_pol_inexact_node *n,
-					      u16 family)
+					      u16 family,
+					      struct list_head *reinsert)
 {
 	unsigned int matched_s, matched_d;
-	struct xfrm_policy *policy, *p;
+	struct xfrm_policy *policy, *p, *tmp;
 
 	matched_s = 0;
 	matched_d = 0;
 
-	list_for_each_entry_reverse(policy, &net->xfrm.policy_all, walk.all) {
+	list_sort(NULL, reinsert, xfrm_policy_reinsert_cmp);
+
+	list_for_each_entry_safe(policy, tmp, reinsert, bydst_reinsert) {
 		struct hlist_node *newpos = NULL;
 		bool matches_s, matches_d;
 
-		if (policy->walk.dead || !policy->bydst_reinsert)
+		list_del_init(&policy->bydst_reinsert);
+		if (policy->walk.dead)
 			continue;
 
 		WARN_ON_ONCE(policy->family != family);
 
-		policy->bydst_reinsert = false;
 		hlist_for_each_entry(p, &n->hhead, bydst) {
 			if (policy->priority > p->priority)
 				newpos = &p->bydst;
@@ -982,16 +1003,18 @@ static void xfrm_policy_inexact_node_reinsert(struct net *net,
 			p = &parent->rb_right;
 		} else {
 			bool same_prefixlen = node->prefixlen == n->prefixlen;
+			LIST_HEAD(reinsert);
 			struct xfrm_policy *tmp;
 
 			hlist_for_each_entry(tmp, &n->hhead, bydst) {
-				tmp->bydst_reinsert = true;
+				list_add_tail(&tmp->bydst_reinsert, &reinsert);
 				hlist_del_rcu(&tmp->bydst);
 			}
 
 			node->prefixlen = prefixlen;
 
-			xfrm_policy_inexact_list_reinsert(net, node, family);
+			xfrm_policy_inexact_list_reinsert(net, node, family,
+							  &reinsert);
 
 			if (same_prefixlen) {
 				kfree_rcu(n, rcu);
@@ -1018,6 +1041,7 @@ static void xfrm_policy_inexact_node_merge(struct net *net,
 	struct xfrm_pol_inexact_node *node;
 	struct xfrm_policy *tmp;
 	struct rb_node *rnode;
+	LIST_HEAD(reinsert);
 
 	/* To-be-merged node v has a subtree.
 	 *
@@ -1031,11 +1055,11 @@ static void xfrm_policy_inexact_node_merge(struct net *net,
 	}
 
 	hlist_for_each_entry(tmp, &v->hhead, bydst) {
-		tmp->bydst_reinsert = true;
+		list_add_tail(&tmp->bydst_reinsert, &reinsert);
 		hlist_del_rcu(&tmp->bydst);
 	}
 
-	xfrm_policy_inexact_list_reinsert(net, n, family);
+	xfrm_policy_inexact_list_reinsert(net, n, family, &reinsert);
 }
 
 static struct xfrm_pol_inexact_node *
@@ -62,6 +62,7 @@ static int xfrm_statistics_seq_show(struct seq_file *seq, void *v)
 	for (i = 0; xfrm_mib_list[i].name; i++)
 		seq_printf(seq, "%-24s\t%lu\n", xfrm_mib_list[i].name,
 						buff[i]);
+	xfrm_mode_cbs_proc_show(net, seq);
 
 	return 0;
 }
@@ -522,6 +522,40 @@ int xfrm_replay_check(struct xfrm_state *x,
 	return xfrm_replay_check_legacy(x, skb, net_seq);
 }
 
+/* Lockless pre-decryption check: returns true when @net_seq is known to be
+ * ahead of the current replay window, which is the common case for in-order
+ * traffic.  The window is only sampled, so the result is advisory: the full
+ * check is done again under x->lock by xfrm_replay_recheck() once the packet
+ * has been authenticated.  A false return requires the full locked check.
+ */
+bool xfrm_replay_check_ahead(const struct xfrm_state *x, __be32 net_seq)
+{
+	const struct xfrm_replay_state_esn *replay_esn = x->replay_esn;
+	u32 seq = ntohl(net_seq);
+	u32 top, wsize;
+
+	switch (x->repl_mode) {
+	case XFRM_REPLAY_MODE_LEGACY:
+		break;
+	case XFRM_REPLAY_MODE_BMP:
+		if (!replay_esn->replay_window)
+			return true;
+		return seq && seq > READ_ONCE(replay_esn->seq);
+	case XFRM_REPLAY_MODE_ESN:
+		wsize = replay_esn->replay_window;
+		if (!wsize)
+			return true;
+		top = READ_ONCE(replay_esn->seq);
+		/* only the same subspace case, the wrap is left to the slow path */
+		return top >= wsize - 1 && seq > top;
+	}
+
+	if (!x->props.replay_window)
+		return true;
+
+	return seq && seq > READ_ONCE(x->replay.seq);
+}
+
 static int xfrm_replay_recheck_esn(struct xfrm_state *x,
 				   struct sk_buff *skb, __be32 net_seq)
 {
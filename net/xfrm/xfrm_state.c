@@ -563,6 +563,20 @@ void xfrm_unregister_mode_cbs(u8 mode)
 }
 EXPORT_SYMBOL(xfrm_unregister_mode_cbs);
 
+void xfrm_mode_cbs_proc_show(struct net *net, struct seq_file *seq)
+{
+	const struct xfrm_mode_cbs *cbs;
+	int mode;
+
+	rcu_read_lock();
+	for (mode = 0; mode < XFRM_MODE_MAX; mode++) {
+		cbs = rcu_dereference(xfrm_mode_cbs_map[mode]);
+		if (cbs && cbs->proc_show)
+			cbs->proc_show(net, seq);
+	}
+	rcu_read_unlock();
+}
+
 static const struct xfrm_mode_cbs *xfrm_get_mode_cbs(u8 mode)
 {
 	const struct xfrm_mode_cbs *cbs;
@@ -2278,6 +2292,26 @@ int xfrm_state_check_expire(struct xfrm_state *x)
 }
 EXPORT_SYMBOL(xfrm_state_check_expire);
 
+/* Lockless variant of xfrm_state_check_expire() for the receive fast path:
+ * returns true only when the state is known to be far from any lifetime
+ * limit and has nothing to update, so that x->lock can be skipped.  A false
+ * return just means the caller has to take the lock and do the full check.
+ */
+bool xfrm_state_expire_nolock_ok(const struct xfrm_state *x)
+{
+	u64 bytes = READ_ONCE(x->curlft.bytes);
+	u64 packets = READ_ONCE(x->curlft.packets);
+
+	if (READ_ONCE(x->xso.dev) || !READ_ONCE(x->curlft.use_time) ||
+	    READ_ONCE(x->km.dying))
+		return false;
+
+	return bytes < x->lft.soft_byte_limit &&
+	       packets < x->lft.soft_packet_limit &&
+	       bytes < x->lft.hard_byte_limit &&
+	       packets < x->lft.hard_packet_limit;
+}
+
 void xfrm_state_update_stats(struct net *net)
 {
 	struct xfrm_state *x;
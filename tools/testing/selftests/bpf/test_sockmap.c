@@ -1602,6 +1602,30 @@ static void test_txmsg_ingress_redir(int cgrp, struct sockmap_options *opt)
 	test_send(opt, cgrp);
 }
 
+static void test_txmsg_skb_ingress_redir(int cgrp, struct sockmap_options *opt)
+{
+	bool data = opt->data_test;
+
+	if (ktls == 1)
+		return;
+
+	/* The skb verdict redirects to the ingress of the receiver, which is
+	 * done inline unless the receiver is backlogged. Verify the payload
+	 * so reordering between the two paths is caught.
+	 */
+	opt->data_test = true;
+	txmsg_pass = 1;
+	txmsg_redir_skb = 1;
+	test_send(opt, cgrp);
+
+	/* Many small messages back to back keep switching between them */
+	opt->iov_length = 64;
+	opt->iov_count = 1;
+	opt->rate = 4096;
+	test_exec(cgrp, opt);
+	opt->data_test = data;
+}
+
 static void test_txmsg_skb(int cgrp, struct sockmap_options *opt)
 {
 	bool data = opt->data_test;
@@ -1988,6 +2012,7 @@ struct _test test[] = {
 	{"txmsg test redirect wait send mem", test_txmsg_redir_wait_sndmem},
 	{"txmsg test drop", test_txmsg_drop},
 	{"txmsg test ingress redirect", test_txmsg_ingress_redir},
+	{"txmsg test skb ingress redirect", test_txmsg_skb_ingress_redir},
 	{"txmsg test skb", test_txmsg_skb},
 	{"txmsg test apply", test_txmsg_apply},
 	{"txmsg test cork", test_txmsg_cork},
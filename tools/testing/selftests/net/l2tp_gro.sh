@@ -0,0 +1,102 @@
+#!/bin/bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Run a TCP stream over an L2TPv3/UDP ethernet pseudowire, with GRO off and
+# on for the underlay, and check what the receiving l2tpeth device gets.
+# It counts one packet per skb, so with GRO on its packets have to be larger
+# than its MTU allows for a single frame, and with GRO off they must not be.
+
+source lib.sh
+source net_helper.sh
+
+DURATION=5
+
+cleanup() {
+	cleanup_all_ns
+}
+
+trap cleanup EXIT
+
+fail() {
+	echo "ERROR: $*" >&2
+	exit $ksft_fail
+}
+
+l2tp_stat() {
+	ip netns exec "$NSRX" cat /sys/class/net/l2tp0/statistics/$1
+}
+
+run_stream() {
+	local gro=$1
+	local pkts bytes avg max
+
+	ip netns exec "$NSRX" ethtool -K veth1 gro "$gro" ||
+		fail "ethtool gro $gro"
+
+	ip netns exec "$NSRX" iperf3 -s -1 > /dev/null &
+	wait_local_port_listen "$NSRX" 5201 tcp
+
+	pkts=$(l2tp_stat rx_packets)
+	bytes=$(l2tp_stat rx_bytes)
+	ip netns exec "$NSTX" iperf3 -c 10.0.0.2 -t "$DURATION" -J \
+		> /dev/null || fail "iperf3 with gro $gro"
+	pkts=$(($(l2tp_stat rx_packets) - pkts))
+	bytes=$(($(l2tp_stat rx_bytes) - bytes))
+	wait
+
+	[ "$pkts" -gt 0 ] || fail "gro $gro: nothing received on l2tp0"
+	avg=$((bytes / pkts))
+	# rx_bytes includes the inner ethernet header
+	max=$(($(ip netns exec "$NSRX" cat /sys/class/net/l2tp0/mtu) + 14))
+
+	printf "gro %-3s: %10u skbs/s, %6u bytes/skb\n" "$gro" \
+		$((pkts / DURATION)) "$avg"
+
+	if [ "$gro" = on ] && [ "$avg" -le "$max" ]; then
+		fail "gro on: no aggregation on l2tp0 ($avg <= $max bytes/skb)"
+	fi
+	if [ "$gro" = off ] && [ "$avg" -gt "$max" ]; then
+		fail "gro off: l2tp0 got aggregated skbs ($avg > $max bytes/skb)"
+	fi
+}
+
+if ! modprobe -q l2tp_eth 2>/dev/null && ! ip l2tp show tunnel &>/dev/null; then
+	echo "SKIP: l2tp_eth not available"
+	exit $ksft_skip
+fi
+
+for tool in iperf3 ethtool; do
+	if ! command -v $tool > /dev/null; then
+		echo "SKIP: $tool not installed"
+		exit $ksft_skip
+	fi
+done
+
+setup_ns NSTX NSRX || exit $ksft_skip
+ip -n "$NSTX" link add veth0 type veth peer name veth1 netns "$NSRX"
+ip -n "$NSTX" addr add 192.0.2.1/24 dev veth0
+ip -n "$NSRX" addr add 192.0.2.2/24 dev veth1
+ip -n "$NSTX" link set veth0 up
+ip -n "$NSRX" link set veth1 up
+
+ip -n "$NSTX" l2tp add tunnel tunnel_id 1 peer_tunnel_id 2 encap udp \
+	local 192.0.2.1 remote 192.0.2.2 udp_sport 5000 udp_dport 6000
+ip -n "$NSTX" l2tp add session name l2tp0 tunnel_id 1 \
+	session_id 10 peer_session_id 20
+ip -n "$NSRX" l2tp add tunnel tunnel_id 2 peer_tunnel_id 1 encap udp \
+	local 192.0.2.2 remote 192.0.2.1 udp_sport 6000 udp_dport 5000
+ip -n "$NSRX" l2tp add session name l2tp0 tunnel_id 2 \
+	session_id 20 peer_session_id 10
+
+ip -n "$NSTX" addr add 10.0.0.1/24 dev l2tp0
+ip -n "$NSRX" addr add 10.0.0.2/24 dev l2tp0
+ip -n "$NSTX" link set l2tp0 up
+ip -n "$NSRX" link set l2tp0 up
+
+ip netns exec "$NSTX" ping -q -c 1 -W 2 10.0.0.2 > /dev/null ||
+	fail "no connectivity over the pseudowire"
+
+run_stream off
+run_stream on
+
+exit $ksft_pass
@@ -0,0 +1,183 @@
+#!/bin/bash
+# SPDX-License-Identifier: GPL-2.0
+
+# Compare the in-kernel MPTCP packet schedulers over two emulated paths with
+# asymmetric rate and delay, reporting the goodput reached by each one.
+
+#shellcheck disable=SC2086
+
+. "$(dirname "${0}")/mptcp_lib.sh"
+
+ns1=""
+ns2=""
+timeout_poll=30
+timeout_test=$((timeout_poll * 2 + 1))
+MPTCP_LIB_TEST_FORMAT="%02u %-50s"
+ret=0
+large=""
+sout=""
+cout=""
+size=$((8 * 1024 * 1024))
+schedulers="default lowrtt redundant wrr"
+
+usage() {
+	echo "Usage: $0 [ -s \"sched1 sched2 ...\" ] [ -d ]"
+	echo -e "\t-s: space separated list of schedulers to test (default: ${schedulers})"
+	echo -e "\t-d: debug this script"
+}
+
+# This function is used in the cleanup trap
+#shellcheck disable=SC2317
+cleanup()
+{
+	rm -f "$cout" "$sout" "$large"
+
+	mptcp_lib_ns_exit "${ns1}" "${ns2}"
+}
+
+mptcp_lib_check_mptcp
+mptcp_lib_check_tools ip tc
+
+#  ns1                    ns2
+#     ns1eth1 -- netem -- ns2eth1
+#     ns1eth2 -- netem -- ns2eth2
+
+setup()
+{
+	large=$(mktemp)
+	sout=$(mktemp)
+	cout=$(mktemp)
+
+	dd if=/dev/zero of=$large bs=4096 count=$((size / 4096)) >/dev/null 2>&1
+
+	trap cleanup EXIT
+
+	mptcp_lib_ns_init ns1 ns2
+
+	ip link add ns1eth1 netns "$ns1" type veth peer name ns2eth1 netns "$ns2"
+	ip link add ns1eth2 netns "$ns1" type veth peer name ns2eth2 netns "$ns2"
+
+	ip -net "$ns1" addr add 10.0.1.1/24 dev ns1eth1
+	ip -net "$ns1" link set ns1eth1 up mtu 1500
+	ip -net "$ns1" addr add 10.0.2.1/24 dev ns1eth2
+	ip -net "$ns1" link set ns1eth2 up mtu 1500
+	ip -net "$ns1" route add default via 10.0.1.2
+
+	ip -net "$ns2" addr add 10.0.1.2/24 dev ns2eth1
+	ip -net "$ns2" link set ns2eth1 up mtu 1500
+	ip -net "$ns2" addr add 10.0.2.2/24 dev ns2eth2
+	ip -net "$ns2" link set ns2eth2 up mtu 1500
+
+	mptcp_lib_pm_nl_set_limits "${ns1}" 1 1
+	mptcp_lib_pm_nl_add_endpoint "${ns1}" 10.0.2.1 dev ns1eth2 flags subflow
+	mptcp_lib_pm_nl_set_limits "${ns2}" 1 1
+}
+
+set_paths()
+{
+	local rate1=$1
+	local rate2=$2
+	local delay1=$3
+	local delay2=$4
+	local dev
+
+	for dev in ns1eth1 ns1eth2; do
+		tc -n $ns1 qdisc del dev $dev root >/dev/null 2>&1
+	done
+	for dev in ns2eth1 ns2eth2; do
+		tc -n $ns2 qdisc del dev $dev root >/dev/null 2>&1
+	done
+	tc -n $ns1 qdisc add dev ns1eth1 root netem rate ${rate1}mbit delay ${delay1}ms
+	tc -n $ns1 qdisc add dev ns1eth2 root netem rate ${rate2}mbit delay ${delay2}ms
+	tc -n $ns2 qdisc add dev ns2eth1 root netem rate ${rate1}mbit delay ${delay1}ms
+	tc -n $ns2 qdisc add dev ns2eth2 root netem rate ${rate2}mbit delay ${delay2}ms
+}
+
+do_transfer()
+{
+	local sched=$1
+	local port=$((10000 + MPTCP_LIB_TEST_COUNTER))
+	local start stop retc rets
+
+	if ! ip netns exec "$ns1" sysctl -q net.mptcp.scheduler="$sched" 2>/dev/null; then
+		mptcp_lib_pr_skip "scheduler not available"
+		return "${KSFT_SKIP}"
+	fi
+	ip netns exec "$ns2" sysctl -q net.mptcp.scheduler="$sched"
+
+	:> "$cout"
+	:> "$sout"
+
+	timeout ${timeout_test} \
+		ip netns exec ${ns2} \
+			./mptcp_connect -jt ${timeout_poll} -l -p $port \
+				0.0.0.0 < /dev/null > "$sout" &
+	local spid=$!
+
+	mptcp_lib_wait_local_port_listen "${ns2}" "${port}"
+
+	start=$(date +%s%N)
+	timeout ${timeout_test} \
+		ip netns exec ${ns1} \
+			./mptcp_connect -jt ${timeout_poll} -p $port \
+				10.0.1.2 < "$large" > "$cout" &
+	local cpid=$!
+
+	wait $cpid
+	retc=$?
+	wait $spid
+	rets=$?
+	stop=$(date +%s%N)
+
+	if [ $retc -ne 0 ] || [ $rets -ne 0 ] || ! cmp -s "$large" "$sout"; then
+		mptcp_lib_pr_fail "client exit code $retc, server $rets"
+		return 1
+	fi
+
+	# goodput in Mbit/s, from the transferred payload and the wall time
+	printf "%10s Mbit/s " "$((size * 8 / ((stop - start) / 1000)))"
+	mptcp_lib_pr_ok
+	return 0
+}
+
+run_test()
+{
+	local msg sched lret
+
+	set_paths "$@"
+	for sched in ${schedulers}; do
+		msg="${sched}: $1/$2 mbit, $3/$4 ms"
+		mptcp_lib_print_title "${msg}"
+		do_transfer "${sched}"
+		lret=$?
+		mptcp_lib_result_code "${lret}" "${msg}"
+		[ $lret -eq 1 ] && ret=1
+	done
+}
+
+while getopts "s:dh" option; do
+	case "$option" in
+	"h")
+		usage $0
+		exit ${KSFT_PASS}
+		;;
+	"s")
+		schedulers="${OPTARG}"
+		;;
+	"d")
+		set -x
+		;;
+	"?")
+		usage $0
+		exit ${KSFT_FAIL}
+		;;
+	esac
+done
+
+setup
+run_test 20 20 5 5
+run_test 20 5 5 50
+run_test 5 20 50 5
+
+mptcp_lib_result_print_all_tap
+exit $ret
@@ -0,0 +1,76 @@
+#!/bin/bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Send pktgen traffic over a veth pair and check that the receive side
+# accounting in /proc/net/pktgen/pgrx sees it, with latency samples.
+
+source lib.sh
+
+COUNT=100000
+
+cleanup() {
+	cleanup_all_ns
+}
+
+trap cleanup EXIT
+
+fail() {
+	echo "ERROR: $*" >&2
+	exit $ksft_fail
+}
+
+pg_set() {
+	local ns=$1
+	local file=$2
+	shift 2
+
+	ip netns exec "$ns" sh -c "echo '$*' > /proc/net/pktgen/$file" ||
+		fail "pktgen $file: $*"
+}
+
+if ! modprobe -q pktgen 2>/dev/null && [ ! -d /proc/net/pktgen ]; then
+	echo "SKIP: pktgen not available"
+	exit $ksft_skip
+fi
+
+setup_ns NSTX NSRX || exit $ksft_skip
+ip -n "$NSTX" link add veth0 type veth peer name veth1 netns "$NSRX"
+ip -n "$NSTX" addr add 192.0.2.1/24 dev veth0
+ip -n "$NSRX" addr add 192.0.2.2/24 dev veth1
+ip -n "$NSTX" link set veth0 up
+ip -n "$NSRX" link set veth1 up
+dst_mac=$(ip -n "$NSRX" -br link show dev veth1 | awk '{print $3}')
+
+if ! ip netns exec "$NSRX" test -e /proc/net/pktgen/pgrx; then
+	echo "SKIP: pktgen without receive accounting"
+	exit $ksft_skip
+fi
+
+pg_set "$NSRX" pgrx "rx veth1"
+
+pg_set "$NSTX" kpktgend_0 "rem_device_all"
+pg_set "$NSTX" kpktgend_0 "add_device veth0"
+pg_set "$NSTX" veth0 "count $COUNT"
+pg_set "$NSTX" veth0 "pkt_size 64"
+pg_set "$NSTX" veth0 "dst 192.0.2.2"
+pg_set "$NSTX" veth0 "dst_mac $dst_mac"
+pg_set "$NSTX" pgctrl "start"
+
+ip netns exec "$NSRX" cat /proc/net/pktgen/pgrx
+rx=$(ip netns exec "$NSRX" awk '/^queue/ { n += $4 } END { print n + 0 }' \
+	/proc/net/pktgen/pgrx)
+[ "$rx" -gt 0 ] || fail "no packets accounted"
+[ "$rx" -le "$COUNT" ] || fail "accounted $rx packets, sent $COUNT"
+ip netns exec "$NSRX" grep -q "latency:" /proc/net/pktgen/pgrx ||
+	fail "no latency samples"
+
+pg_set "$NSRX" pgrx "rx_reset"
+rx=$(ip netns exec "$NSRX" grep -c "^queue" /proc/net/pktgen/pgrx)
+[ "$rx" -eq 0 ] || fail "counters not reset"
+
+pg_set "$NSRX" pgrx "rx_stop"
+ip netns exec "$NSRX" grep -q "RX: off" /proc/net/pktgen/pgrx ||
+	fail "receive hook still active"
+
+echo "PASS: $COUNT sent"
+exit $ksft_pass
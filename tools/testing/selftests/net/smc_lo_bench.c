@@ -0,0 +1,295 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/* Compare local stream throughput of SMC-D over the loopback-ism device
+ * with AF_UNIX and TCP over the loopback interface.
+ *
+ * For each socket family a child process streams fixed size messages to
+ * the parent for the given duration, and the parent reports the rate at
+ * which it received them. SMC needs the loopback-ism device to be present,
+ * otherwise the connection silently falls back to TCP. The mode of the
+ * accepted connection is looked up through sock_diag, and the SMC run is
+ * skipped unless it really uses SMC-D.
+ */
+
+#include <errno.h>
+#include <error.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <linux/netlink.h>
+#include <linux/sock_diag.h>
+#include <linux/smc_diag.h>
+
+#include "../kselftest.h"
+
+#ifndef AF_SMC
+#define AF_SMC		43
+#endif
+#define SMCPROTO_SMC	0
+
+#define BENCH_PORT	18977
+
+static unsigned int msg_size = 64 * 1024;
+static unsigned int duration = 5;
+static volatile bool stop;
+
+enum bench_family {
+	BENCH_SMC,
+	BENCH_UNIX,
+	BENCH_TCP,
+};
+
+static const char * const bench_names[] = {
+	[BENCH_SMC]	= "smc-d loopback",
+	[BENCH_UNIX]	= "af_unix",
+	[BENCH_TCP]	= "tcp loopback",
+};
+
+static void sigalrm(int sig)
+{
+	stop = true;
+}
+
+static int bench_socket(enum bench_family fam)
+{
+	int fd;
+
+	switch (fam) {
+	case BENCH_SMC:
+		fd = socket(AF_SMC, SOCK_STREAM, SMCPROTO_SMC);
+		break;
+	case BENCH_UNIX:
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		break;
+	default:
+		fd = socket(AF_INET, SOCK_STREAM, 0);
+		break;
+	}
+	return fd;
+}
+
+/* mode of the established SMC connection on local @port, -1 if unknown */
+static int smc_diag_mode(unsigned short port)
+{
+	struct {
+		struct nlmsghdr nlh;
+		struct smc_diag_req req;
+	} msg = {
+		.nlh = {
+			.nlmsg_len	= sizeof(msg),
+			.nlmsg_type	= SOCK_DIAG_BY_FAMILY,
+			.nlmsg_flags	= NLM_F_REQUEST | NLM_F_DUMP,
+		},
+		.req = {
+			.diag_family	= AF_SMC,
+		},
+	};
+	struct smc_diag_msg *diag;
+	struct nlmsghdr *nlh;
+	bool done = false;
+	int fd, mode = -1;
+	char buf[8192];
+	ssize_t len;
+
+	fd = socket(AF_NETLINK, SOCK_DGRAM, NETLINK_SOCK_DIAG);
+	if (fd < 0)
+		error(1, errno, "socket(NETLINK_SOCK_DIAG)");
+	if (send(fd, &msg, sizeof(msg), 0) < 0)
+		error(1, errno, "send(sock_diag)");
+
+	while (!done && (len = recv(fd, buf, sizeof(buf), 0)) > 0) {
+		for (nlh = (struct nlmsghdr *)buf; NLMSG_OK(nlh, len);
+		     nlh = NLMSG_NEXT(nlh, len)) {
+			if (nlh->nlmsg_type == NLMSG_DONE ||
+			    nlh->nlmsg_type == NLMSG_ERROR) {
+				done = true;
+				break;
+			}
+			diag = NLMSG_DATA(nlh);
+			if (diag->diag_state != TCP_LISTEN &&
+			    ntohs(diag->id.idiag_sport) == port)
+				mode = diag->diag_mode;
+		}
+	}
+
+	close(fd);
+	return mode;
+}
+
+static socklen_t bench_addr(enum bench_family fam,
+			    struct sockaddr_storage *ss)
+{
+	struct sockaddr_in *sin = (struct sockaddr_in *)ss;
+	struct sockaddr_un *sun = (struct sockaddr_un *)ss;
+
+	memset(ss, 0, sizeof(*ss));
+	if (fam == BENCH_UNIX) {
+		/* abstract namespace, nothing to clean up */
+		sun->sun_family = AF_UNIX;
+		snprintf(sun->sun_path + 1, sizeof(sun->sun_path) - 1,
+			 "smc_lo_bench.%d", getpid());
+		return sizeof(*sun);
+	}
+
+	sin->sin_family = AF_INET;
+	sin->sin_port = htons(BENCH_PORT + fam);
+	sin->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	return sizeof(*sin);
+}
+
+static void run_sender(enum bench_family fam, struct sockaddr_storage *ss,
+		       socklen_t len)
+{
+	char *buf;
+	int fd;
+
+	buf = calloc(1, msg_size);
+	if (!buf)
+		error(1, ENOMEM, "calloc");
+
+	fd = bench_socket(fam);
+	if (fd < 0)
+		error(1, errno, "socket");
+	if (connect(fd, (struct sockaddr *)ss, len))
+		error(1, errno, "connect");
+
+	while (!stop) {
+		if (send(fd, buf, msg_size, 0) < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+	}
+
+	close(fd);
+	free(buf);
+	exit(0);
+}
+
+static int run_bench(enum bench_family fam)
+{
+	unsigned long long bytes = 0;
+	struct sockaddr_storage ss;
+	struct timeval start, end;
+	int lfd, fd, status;
+	double secs;
+	socklen_t len;
+	ssize_t ret;
+	char *buf;
+	pid_t pid;
+
+	lfd = bench_socket(fam);
+	if (lfd < 0) {
+		if (errno == EAFNOSUPPORT) {
+			ksft_print_msg("%s: not supported\n", bench_names[fam]);
+			return KSFT_SKIP;
+		}
+		error(1, errno, "socket");
+	}
+
+	len = bench_addr(fam, &ss);
+	if (setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &(int){ 1 },
+		       sizeof(int)))
+		error(1, errno, "setsockopt(SO_REUSEADDR)");
+	if (bind(lfd, (struct sockaddr *)&ss, len))
+		error(1, errno, "bind");
+	if (listen(lfd, 1))
+		error(1, errno, "listen");
+
+	stop = false;
+	fflush(stdout);
+	pid = fork();
+	if (pid < 0)
+		error(1, errno, "fork");
+	if (!pid) {
+		close(lfd);
+		alarm(duration);
+		run_sender(fam, &ss, len);
+	}
+
+	fd = accept(lfd, NULL, NULL);
+	if (fd < 0)
+		error(1, errno, "accept");
+
+	if (fam == BENCH_SMC &&
+	    smc_diag_mode(BENCH_PORT + fam) != SMC_DIAG_MODE_SMCD) {
+		ksft_print_msg("%s: connection does not use SMC-D, skipping\n",
+			       bench_names[fam]);
+		/* the sender stops on the broken pipe */
+		close(fd);
+		waitpid(pid, &status, 0);
+		close(lfd);
+		return KSFT_SKIP;
+	}
+
+	buf = malloc(msg_size);
+	if (!buf)
+		error(1, ENOMEM, "malloc");
+
+	gettimeofday(&start, NULL);
+	while ((ret = recv(fd, buf, msg_size, 0)) > 0)
+		bytes += ret;
+	gettimeofday(&end, NULL);
+
+	if (ret < 0)
+		error(1, errno, "recv");
+	if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+	    WEXITSTATUS(status))
+		error(1, 0, "sender failed");
+
+	secs = (end.tv_sec - start.tv_sec) +
+	       (end.tv_usec - start.tv_usec) / 1000000.0;
+	printf("%-16s %8.2f Gbit/s %10.0f msg/s\n", bench_names[fam],
+	       bytes * 8 / secs / 1e9, bytes / msg_size / secs);
+
+	free(buf);
+	close(fd);
+	close(lfd);
+	return KSFT_PASS;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-s msg_size] [-d seconds]\n", prog);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	int opt, ret = KSFT_PASS;
+
+	while ((opt = getopt(argc, argv, "s:d:")) != -1) {
+		switch (opt) {
+		case 's':
+			msg_size = atoi(optarg);
+			break;
+		case 'd':
+			duration = atoi(optarg);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (!msg_size || !duration)
+		usage(argv[0]);
+
+	signal(SIGALRM, sigalrm);
+	signal(SIGPIPE, SIG_IGN);
+
+	if (run_bench(BENCH_SMC) == KSFT_SKIP)
+		ret = KSFT_SKIP;
+	run_bench(BENCH_UNIX);
+	run_bench(BENCH_TCP);
+
+	return ret;
+}
@@ -0,0 +1,217 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/* Run concurrent TIPC bind/unbind and anycast lookup storms against the same
+ * service type and report the rate each side achieved.
+ *
+ * Binder threads repeatedly bind and unbind their own instance range of the
+ * service, while sender threads send datagrams to instances held by a
+ * receiver socket, each send doing a name table anycast lookup.
+ */
+
+#include <errno.h>
+#include <error.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <linux/tipc.h>
+
+#include "../kselftest.h"
+
+#define SERVICE_TYPE	18888
+#define RECV_INSTANCES	64
+#define BIND_INSTANCES	256
+
+static unsigned int nr_binders = 4;
+static unsigned int nr_senders = 4;
+static unsigned int duration = 5;
+static volatile bool stop;
+
+struct worker {
+	pthread_t thread;
+	unsigned int id;
+	unsigned long ops;
+	unsigned long errs;
+};
+
+static int tipc_socket(void)
+{
+	int fd;
+
+	fd = socket(AF_TIPC, SOCK_RDM, 0);
+	if (fd < 0) {
+		if (errno == EAFNOSUPPORT)
+			ksft_exit_skip("TIPC not supported\n");
+		error(1, errno, "socket(AF_TIPC)");
+	}
+	return fd;
+}
+
+static int tipc_bind_range(int fd, unsigned int lower, unsigned int upper,
+			   bool unbind)
+{
+	struct sockaddr_tipc sa = {
+		.family = AF_TIPC,
+		.addrtype = TIPC_SERVICE_RANGE,
+		.scope = unbind ? -TIPC_NODE_SCOPE : TIPC_NODE_SCOPE,
+		.addr.nameseq.type = SERVICE_TYPE,
+		.addr.nameseq.lower = lower,
+		.addr.nameseq.upper = upper,
+	};
+
+	return bind(fd, (struct sockaddr *)&sa, sizeof(sa));
+}
+
+static void *binder(void *arg)
+{
+	struct worker *w = arg;
+	unsigned int base, i = 0;
+	int fd;
+
+	fd = tipc_socket();
+	base = RECV_INSTANCES + w->id * BIND_INSTANCES;
+
+	while (!stop) {
+		unsigned int inst = base + i++ % BIND_INSTANCES;
+
+		if (tipc_bind_range(fd, inst, inst, false) ||
+		    tipc_bind_range(fd, inst, inst, true))
+			w->errs++;
+		else
+			w->ops += 2;
+	}
+
+	close(fd);
+	return NULL;
+}
+
+static void *sender(void *arg)
+{
+	struct sockaddr_tipc sa = {
+		.family = AF_TIPC,
+		.addrtype = TIPC_SERVICE_ADDR,
+		.addr.name.name.type = SERVICE_TYPE,
+	};
+	struct worker *w = arg;
+	unsigned int i = 0;
+	char buf = 0;
+	int fd;
+
+	fd = tipc_socket();
+
+	while (!stop) {
+		sa.addr.name.name.instance = i++ % RECV_INSTANCES;
+		if (sendto(fd, &buf, sizeof(buf), MSG_DONTWAIT,
+			   (struct sockaddr *)&sa, sizeof(sa)) < 0 &&
+		    errno != EAGAIN)
+			w->errs++;
+		else
+			w->ops++;
+	}
+
+	close(fd);
+	return NULL;
+}
+
+static void *receiver(void *arg)
+{
+	struct timeval tv = { .tv_usec = 100000 };
+	int fd = *(int *)arg;
+	char buf[64];
+
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	while (!stop)
+		recv(fd, buf, sizeof(buf), 0);
+	return NULL;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-b binders] [-s senders] [-d seconds]\n",
+		prog);
+	exit(1);
+}
+
+static unsigned long run(struct worker *w, unsigned int nr, unsigned long *errs)
+{
+	unsigned long ops = 0;
+	unsigned int i;
+
+	for (i = 0; i < nr; i++) {
+		pthread_join(w[i].thread, NULL);
+		ops += w[i].ops;
+		*errs += w[i].errs;
+	}
+	return ops;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long bind_ops, send_ops, bind_errs = 0, send_errs = 0;
+	struct worker *binders, *senders;
+	pthread_t recv_thread;
+	int opt, rfd;
+	unsigned int i;
+
+	while ((opt = getopt(argc, argv, "b:s:d:")) != -1) {
+		switch (opt) {
+		case 'b':
+			nr_binders = atoi(optarg);
+			break;
+		case 's':
+			nr_senders = atoi(optarg);
+			break;
+		case 'd':
+			duration = atoi(optarg);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	rfd = tipc_socket();
+	if (tipc_bind_range(rfd, 0, RECV_INSTANCES - 1, false))
+		error(1, errno, "bind receiver");
+	if (pthread_create(&recv_thread, NULL, receiver, &rfd))
+		error(1, errno, "pthread_create(receiver)");
+
+	binders = calloc(nr_binders, sizeof(*binders));
+	senders = calloc(nr_senders, sizeof(*senders));
+	if (!binders || !senders)
+		error(1, ENOMEM, "calloc");
+
+	for (i = 0; i < nr_binders; i++) {
+		binders[i].id = i;
+		if (pthread_create(&binders[i].thread, NULL, binder, &binders[i]))
+			error(1, errno, "pthread_create(binder)");
+	}
+	for (i = 0; i < nr_senders; i++) {
+		senders[i].id = i;
+		if (pthread_create(&senders[i].thread, NULL, sender, &senders[i]))
+			error(1, errno, "pthread_create(sender)");
+	}
+
+	sleep(duration);
+	stop = true;
+
+	bind_ops = run(binders, nr_binders, &bind_errs);
+	send_ops = run(senders, nr_senders, &send_errs);
+	pthread_join(recv_thread, NULL);
+	close(rfd);
+
+	printf("binders %u: %lu bind+unbind/s (%lu errors)\n", nr_binders,
+	       bind_ops / duration, bind_errs);
+	printf("senders %u: %lu lookups/s (%lu errors)\n", nr_senders,
+	       send_ops / duration, send_errs);
+
+	free(binders);
+	free(senders);
+
+	if (bind_errs || send_errs)
+		return KSFT_FAIL;
+	return KSFT_PASS;
+}
@@ -50,6 +50,32 @@ do_dummies4() {
 
 setup_ns ns
 
+# 10.1.1.1 -> 10.101.1.1 matches the first generated policy
+ip -net "$ns" link add dummy0 type dummy
+ip -net "$ns" addr add 10.1.1.1/8 dev dummy0
+ip -net "$ns" link set dummy0 up
+
+lookups=20000
+[ "$KSFT_MACHINE_SLOW" = "yes" ] && lookups=2000
+
+# Every send is blocked by the policy, so each datagram costs one full
+# policy lookup and no more: the rate at which sends fail with EPERM is
+# the lookup rate.
+do_lookup_bench()
+{
+	local policies="$1"
+	local rate
+
+	if ! rate=$(ip netns exec "$ns" ./xfrm_policy_lookup 10.1.1.1 \
+			10.101.1.1 "$lookups"); then
+		echo "WARNING: policy lookup benchmark failed"
+		ret=1
+		return
+	fi
+
+	printf "Looked up %-6s policies at %d lookups/s\n" "$policies" "$rate"
+}
+
 do_bench()
 {
 	local max="$1"
@@ -65,13 +91,15 @@ do_bench()
 	result=$((stop-start))
 
 	policies=$(wc -l < "$tmp")
-	printf "Inserted %-06s policies in $result ms\n" $policies
+	printf "Inserted %-6s policies in $result ms\n" $policies
 
 	have=$(ip netns exec "$ns" ip xfrm policy show | grep "action block" | wc -l)
 	if [ "$have" -ne "$policies" ]; then
 		echo "WARNING: mismatch, have $have policies, expected $policies"
 		ret=1
 	fi
+
+	do_lookup_bench "$policies"
 }
 
 p=100
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Send UDP datagrams that an xfrm "block" policy rejects and report how
+ * many were rejected per second. Each send fails in the policy lookup with
+ * EPERM, so this is the output policy lookup rate.
+ *
+ * usage: xfrm_policy_lookup <saddr> <daddr> <count>
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <error.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+int main(int argc, char **argv)
+{
+	struct sockaddr_in src = { .sin_family = AF_INET };
+	struct sockaddr_in dst = { .sin_family = AF_INET, .sin_port = htons(9) };
+	struct timespec start, end;
+	unsigned long count, i;
+	char payload = 0;
+	double secs;
+	int fd;
+
+	if (argc != 4)
+		error(1, 0, "usage: %s <saddr> <daddr> <count>", argv[0]);
+
+	if (inet_pton(AF_INET, argv[1], &src.sin_addr) != 1 ||
+	    inet_pton(AF_INET, argv[2], &dst.sin_addr) != 1)
+		error(1, 0, "bad address");
+	count = strtoul(argv[3], NULL, 0);
+	if (!count)
+		error(1, 0, "bad count");
+
+	fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0)
+		error(1, errno, "socket");
+	if (bind(fd, (void *)&src, sizeof(src)))
+		error(1, errno, "bind");
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < count; i++) {
+		if (sendto(fd, &payload, sizeof(payload), 0, (void *)&dst,
+			   sizeof(dst)) >= 0)
+			error(1, 0, "send %lu was not blocked by a policy", i);
+		if (errno != EPERM)
+			error(1, errno, "send %lu", i);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	secs = end.tv_sec - start.tv_sec +
+	       (end.tv_nsec - start.tv_nsec) / 1e9;
+	if (secs <= 0)
+		secs = 1e-9;
+	printf("%.0f\n", count / secs);
+
+	close(fd);
+	return 0;
+}